@@ -0,0 +1,132 @@
+/*
+Copyright (C) 2017 Jonathon Ogden < jeog.dev@gmail.com >
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see http://www.gnu.org/licenses.
+*/
+
+#ifndef JO_SOB_BACKTEST_RUNNER
+#define JO_SOB_BACKTEST_RUNNER
+
+#include <vector>
+#include <functional>
+#include <memory>
+#include <exception>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+
+#include "common.hpp"
+#include "simpleorderbook.hpp"
+#include "worker_pool.hpp"
+
+namespace sob {
+
+/*
+ *   BacktestRunner :
+ *
+ *      Runs a set of independent jobs - each a book factory and an order
+ *      stream that drives the book it creates - on a work-stealing
+ *      WorkerPool (one thread per core by default). Books are created
+ *      INLINE (see SimpleOrderbook::UseInlineExecution) on the worker that
+ *      runs the job, so orders are executed on that thread w/o a
+ *      dispatcher or callback thread of their own; the book is destroyed
+ *      when the stream returns. (Books are created/destroyed one at a time
+ *      since the factory proxies' resource managers aren't thread-safe.)
+ *
+ *      .add : queue a job; returns its index in the results
+ *      .run : run everything added since the last run and block until it's
+ *             done; results are in the order the jobs were added, whatever
+ *             order they were run in
+ *
+ *   BacktestRunner::job_result :
+ *
+ *      the book's final state, how long the stream took (creating and
+ *      destroying the book aren't included) and the exception the job
+ *      threw, if any (the rest of the jobs still run)
+ */
+class BacktestRunner {
+public:
+    using factory_type = std::function<FullInterface*()>;
+    using stream_type = std::function<void(FullInterface*)>;
+
+    struct job_result {
+        std::chrono::duration<double> elapsed; // seconds
+        unsigned long long volume;
+        double last_price;
+        double bid_price;
+        double ask_price;
+        size_t ntrades;
+        std::exception_ptr error;
+
+        job_result()
+            : elapsed(0), volume(0), last_price(0), bid_price(0),
+              ask_price(0), ntrades(0), error()
+            {}
+
+        inline operator bool() const
+        { return !error; }
+    };
+
+    /* 0 = std::thread::hardware_concurrency() */
+    explicit BacktestRunner(unsigned int nthreads = 0);
+    ~BacktestRunner();
+
+    BacktestRunner(const BacktestRunner& runner) = delete;
+    BacktestRunner& operator=(const BacktestRunner& runner) = delete;
+
+    size_t
+    add(factory_type factory, stream_type stream);
+
+    template<typename CTy>
+    inline size_t
+    add( const SimpleOrderbook::FactoryProxy<CTy>& proxy,
+         double min_price,
+         double max_price,
+         stream_type stream )
+    {
+        return add( [=](){ return proxy.create(min_price, max_price); },
+                    stream );
+    }
+
+    std::vector<job_result>
+    run();
+
+    inline size_t
+    size() const
+    { return _jobs.size(); }
+
+    inline unsigned int
+    nthreads() const
+    { return _pool.size(); }
+
+private:
+    class job;
+
+    WorkerPool _pool;
+    std::vector<std::unique_ptr<job>> _jobs;
+
+    /* the current run */
+    std::vector<job_result> *_results;
+    size_t _remaining;
+    std::mutex _done_mtx;
+    std::condition_variable _done_cond;
+    std::mutex _books_mtx;
+
+    void
+    _run_job(size_t index);
+};
+
+}; /* sob */
+
+#endif /* JO_SOB_BACKTEST_RUNNER */
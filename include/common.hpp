@@ -37,9 +37,43 @@ class SimpleOrderbook; /* simpleoderbook.hpp */
 class OrderParamaters; /* order_paramaters.hpp */
 class AdvancedOrderTicket; /* advanced_order.hpp */
 struct order_info; /* simpleoderbook.hpp */
+struct order_status; /* simpleoderbook.hpp */
+struct top_of_book; /* simpleoderbook.hpp */
+struct depth_snapshot; /* simpleoderbook.hpp */
+struct depth_delta; /* simpleoderbook.hpp */
+struct depth_level; /* simpleoderbook.hpp */
+struct level_view; /* simpleoderbook.hpp */
+struct order_view; /* simpleoderbook.hpp */
+struct order_event; /* simpleoderbook.hpp */
+template<typename T> class FeedRing; /* simpleoderbook.hpp */
+using DepthDeltaRing = FeedRing<depth_delta>;
+using OrderEventRing = FeedRing<order_event>;
 
 using id_type = unsigned long;
 
+/*
+ * client-assigned order IDs live in their own id space - marked by the high
+ * bit - so they can never collide with the IDs generated by the engine
+ */
+constexpr id_type client_id_flag = ~(~id_type(0) >> 1);
+
+constexpr id_type
+make_client_id(id_type n)
+{ return n | client_id_flag; }
+
+constexpr bool
+is_client_id(id_type id)
+{ return (id & client_id_flag) != 0; }
+
+/*
+ * result of a replace that was superseded (see set_replace_coalescing)
+ * before it got to the front of the queue; never a valid order ID
+ */
+constexpr id_type superseded_id = ~id_type(0);
+
+/* tag (e.g a session or trader) that orders can be inserted/mass-pulled by */
+using owner_type = unsigned int;
+
 using quarter_tick = std::ratio<1,4>;
 using tenth_tick = std::ratio<1,10>;
 using thirty_secondth_tick = std::ratio<1,32>;
@@ -49,6 +83,33 @@ using ten_thousandth_tick = std::ratio<1,10000>;
 
 using clock_type = std::chrono::steady_clock;
 
+/*
+ * where a book gets the time it stamps trades w/ (see
+ * ManagementInterface::set_clock); null = clock_type::now
+ */
+using clock_source_type = std::function<clock_type::time_point()>;
+
+/* a clock source for replays: starts at 'start', advances 'step' per read */
+struct simulated_clock {
+    clock_type::time_point time;
+    clock_type::duration step;
+
+    explicit simulated_clock( clock_type::time_point start
+                                  = clock_type::time_point(),
+                              clock_type::duration step
+                                  = clock_type::duration::zero() )
+        : time(start), step(step)
+        {}
+
+    inline clock_type::time_point
+    operator()()
+    {
+        clock_type::time_point t = time;
+        time += step;
+        return t;
+    }
+};
+
 using timesale_entry_type = std::tuple<clock_type::time_point, double, size_t>;
 
 enum class order_type {
@@ -120,14 +181,136 @@ enum class side_of_trade {
     both = 3
 };
 
+/* how the dispatcher and async callback threads wait for work */
+enum class wait_strategy {
+    blocking = 0, // sleep on a condition variable
+    spin_yield, // spin for a bit, then yield the core between checks
+    busy_spin // never give up the core
+};
+
+enum class sob_thread {
+    dispatcher = 1,
+    async_callback = 2,
+    both = 3
+};
+
+/* what happens to new orders when the dispatcher's queue is full */
+enum class overflow_policy {
+    block = 0, // wait for room
+    reject, // throw queue_full_error
+    shed // reject, but let pulls(by order ID) in by dropping the newest order
+};
+
+/* what happened to an order (see order_event) */
+enum class order_event_type : unsigned char {
+    add = 0, // rests in the book
+    cancel, // pulled (incl. the old order of a replace)
+    modify, // still resting w/ a new size (or, for trailing stops, tick)
+    fill, // one side of a trade
+    stop_trigger // stop left the book; its order is 'parent_id'
+};
+
+/*
+ * which of an owner's orders pull_all should cancel; a price of 0 leaves
+ * that end of the range open, order_type::null matches any type (limit
+ * matches AON limits, stop/stop_limit are matched on the stop price)
+ */
+struct pull_filter {
+    side_of_trade side;
+    double min_price;
+    double max_price;
+    order_type type;
+
+    pull_filter( side_of_trade side = side_of_trade::both,
+                 double min_price = 0,
+                 double max_price = 0,
+                 order_type type = order_type::null )
+        : side(side), min_price(min_price), max_price(max_price), type(type)
+        {}
+};
+
+/* how long orders wait in the dispatcher's queue (see ManagementInterface) */
+struct queue_time_stats {
+    unsigned long long count;
+    clock_type::duration total;
+    clock_type::duration max;
+
+    queue_time_stats()
+        : count(0), total(clock_type::duration::zero()),
+          max(clock_type::duration::zero())
+        {}
+
+    inline clock_type::duration
+    mean() const
+    { return count ? total / static_cast<clock_type::rep>(count)
+                   : clock_type::duration::zero(); }
+};
+
+/* one OHLCV bar (see ManagementInterface::add_bar_interval) */
+struct bar {
+    clock_type::time_point start; // a multiple of the interval
+    double open;
+    double high;
+    double low;
+    double close;
+    unsigned long long volume;
+    double vwap;
+    size_t ntrades; // fills, as in time_and_sales
+
+    bar()
+        : start(), open(0), high(0), low(0), close(0), volume(0), vwap(0),
+          ntrades(0)
+        {}
+};
+
+/* what a market order would get (see QueryInterface::estimate_fill) */
+struct fill_estimate {
+    size_t filled; // < the size asked for if there isn't enough liquidity
+    double vwap;
+    double worst_price; // of the last level it would reach
+    size_t levels; // # of price levels it would trade at
+
+    fill_estimate()
+        : filled(0), vwap(0), worst_price(0), levels(0)
+        {}
+};
+
 using order_exec_cb_type = std::function<
     void(callback_msg,id_type,id_type,double,size_t)
     >;
 
+/* a callback and its args, e.g collected by an inline book instead of run */
+struct callback_event {
+    callback_msg msg;
+    order_exec_cb_type exec_cb;
+    id_type id1;
+    id_type id2;
+    double price;
+    size_t sz;
+
+    callback_event(callback_msg msg, const order_exec_cb_type& exec_cb,
+                   id_type id1, id_type id2, double price, size_t sz)
+        : msg(msg), exec_cb(exec_cb), id1(id1), id2(id2), price(price), sz(sz)
+        {}
+
+    callback_event()
+        : msg(callback_msg::cancel), exec_cb(nullptr), id1(0), id2(0),
+          price(0.0), sz(0)
+        {}
+
+    inline void
+    operator()() const
+    { exec_cb(msg, id1, id2, price, sz); }
+};
+
 std::string to_string(const order_type& ot);
 std::string to_string(const callback_msg& cm);
 std::string to_string(const side_of_market& s);
 std::string to_string(const side_of_trade& s);
+std::string to_string(const wait_strategy& ws);
+std::string to_string(const sob_thread& t);
+std::string to_string(const overflow_policy& op);
+std::string to_string(const order_event_type& et);
 std::string to_string(const clock_type::time_point& tp);
 std::string to_string(const order_condition& oc);
 std::string to_string(const condition_trigger& ct);
@@ -140,6 +323,10 @@ std::ostream& operator<<(std::ostream& out, const order_type& ot);
 std::ostream& operator<<(std::ostream& out, const callback_msg& cm);
 std::ostream& operator<<(std::ostream& out, const side_of_market& s);
 std::ostream& operator<<(std::ostream& out, const side_of_trade& s);
+std::ostream& operator<<(std::ostream& out, const wait_strategy& ws);
+std::ostream& operator<<(std::ostream& out, const sob_thread& t);
+std::ostream& operator<<(std::ostream& out, const overflow_policy& op);
+std::ostream& operator<<(std::ostream& out, const order_event_type& et);
 std::ostream& operator<<(std::ostream& out, const clock_type::time_point& tp);
 std::ostream& operator<<(std::ostream& out, const order_condition& oc);
 std::ostream& operator<<(std::ostream& out, const condition_trigger& ct);
@@ -160,6 +347,10 @@ INLINE_OPERATOR_PLUS_STR(order_type);
 INLINE_OPERATOR_PLUS_STR(callback_msg);
 INLINE_OPERATOR_PLUS_STR(side_of_market);
 INLINE_OPERATOR_PLUS_STR(side_of_trade);
+INLINE_OPERATOR_PLUS_STR(wait_strategy);
+INLINE_OPERATOR_PLUS_STR(sob_thread);
+INLINE_OPERATOR_PLUS_STR(overflow_policy);
+INLINE_OPERATOR_PLUS_STR(order_event_type);
 INLINE_OPERATOR_PLUS_STR(clock_type::time_point);
 INLINE_OPERATOR_PLUS_STR(order_condition);
 INLINE_OPERATOR_PLUS_STR(condition_trigger);
@@ -190,6 +381,13 @@ public:
     using std::out_of_range::out_of_range;
 };
 
+/* order turned away (or dropped) because the dispatcher's queue was full */
+class queue_full_error
+        : public std::runtime_error{
+public:
+    using std::runtime_error::runtime_error;
+};
+
 template<typename T>
 constexpr bool
 equal(T l, T r)
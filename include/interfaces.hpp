@@ -20,9 +20,12 @@ along with this program. If not, see http://www.gnu.org/licenses.
 
 #include <vector>
 #include <map>
+#include <memory>
+#include <type_traits>
 
 #include "common.hpp"
 #include "advanced_order.hpp"
+#include "order_batch.hpp"
 
 namespace sob{
 
@@ -96,6 +99,14 @@ public:
     virtual id_type
     last_id() const = 0;
 
+    /* consistent snapshot of all of the above (as of the last window) */
+    virtual top_of_book
+    get_top_of_book() const = 0;
+
+    /* top-N levels as of the last window (see set_depth_snapshot_levels) */
+    virtual depth_snapshot
+    get_depth_snapshot() const = 0;
+
     virtual std::map<double,size_t> 
     bid_depth(size_t depth=8) const = 0;
 
@@ -105,13 +116,48 @@ public:
     virtual std::map<double,std::pair<size_t, side_of_market>>
     market_depth(size_t depth=8) const = 0;
 
+    /*
+     * the same levels as bid_depth/ask_depth written to a caller-provided
+     * array w/o allocating: up to 'n' non-empty levels, best price first;
+     * returns the number written
+     */
+    virtual size_t
+    bid_depth_levels(depth_level *levels, size_t n) const = 0;
+
+    virtual size_t
+    ask_depth_levels(depth_level *levels, size_t n) const = 0;
+
+    /*
+     * what a market order of 'size' would fill against the book as it is
+     * now (w/o changing it); AONs are only counted if they'd be filled
+     * completely, as the order walks the book
+     */
+    virtual fill_estimate
+    estimate_fill(bool buy, size_t size) const = 0;
+
     /* new elems get put on back i.e beg() == oldest, end() == newest */
     virtual const std::vector<timesale_entry_type>&
     time_and_sales() const = 0;
 
+    /*
+     * copy the last (up to) 'n' bars of 'interval', oldest first, to 'out';
+     * returns the number copied. The newest may still be open. Intervals w/
+     * no trades don't get a bar. Throws invalid_argument if 'interval' isn't
+     * kept (see ManagementInterface::add_bar_interval)
+     */
+    virtual size_t
+    bars(clock_type::duration interval, bar *out, size_t n) const = 0;
+
     virtual order_info
     get_order_info(id_type id) const = 0;
 
+    /*
+     * compact status of ids[0..n) (engine or client IDs) to out[0..n) all
+     * under one lock; returns the number still in the book
+     */
+    virtual size_t
+    get_order_status(const id_type *ids, size_t n, order_status *out) const = 0;
+
     /* NEW - AON orders */
     virtual std::map<double, std::pair<size_t,size_t>>
     aon_market_depth() const = 0;
@@ -141,7 +187,9 @@ public:
                        size_t size,
                        order_exec_cb_type exec_cb = nullptr,
                        const AdvancedOrderTicket& advanced
-                           = AdvancedOrderTicket::null) = 0;
+                           = AdvancedOrderTicket::null,
+                       id_type client_id = 0,
+                       owner_type owner = 0) = 0;
 
     virtual id_type
     replace_with_limit_order(id_type id, 
@@ -152,16 +200,31 @@ public:
                              const AdvancedOrderTicket& advanced
                                  = AdvancedOrderTicket::null) = 0;
 
+    /*
+     * change the size of a live order; a decrease is done in place (same ID,
+     * keeps its place in line), an increase is a replace (returns new ID);
+     * throws advanced_order_error for OCO legs and active bracket/trailing
+     * stop orders
+     */
+    virtual id_type
+    modify_order(id_type id, size_t new_size) = 0;
+
     virtual bool 
     pull_order(id_type id) = 0;
 
+    /* pull all of an owner's orders (in one window), returns # pulled */
+    virtual size_t
+    pull_all(owner_type owner, const pull_filter& filter = pull_filter()) = 0;
+
     virtual std::future<id_type>
     insert_limit_order_async(bool buy,
                              double limit,
                              size_t size,
                              order_exec_cb_type exec_cb = nullptr,
                              const AdvancedOrderTicket& advanced
-                                 = AdvancedOrderTicket::null) = 0;
+                                 = AdvancedOrderTicket::null,
+                             id_type client_id = 0,
+                             owner_type owner = 0) = 0;
 
     virtual std::future<id_type>
     replace_with_limit_order_async(id_type id,
@@ -172,9 +235,16 @@ public:
                                    const AdvancedOrderTicket& advanced
                                        = AdvancedOrderTicket::null) = 0;
 
+    virtual std::future<id_type>
+    modify_order_async(id_type id, size_t new_size) = 0;
+
     virtual std::future<id_type> // 1 = true, 0 = false
     pull_order_async(id_type id) = 0;
 
+    virtual std::future<id_type> // # pulled
+    pull_all_async(owner_type owner,
+                   const pull_filter& filter = pull_filter()) = 0;
+
     virtual void
     wait_for_async_callbacks() = 0;
 };
@@ -193,7 +263,9 @@ public:
                         size_t size, 
                         order_exec_cb_type exec_cb = nullptr,
                         const AdvancedOrderTicket& advanced
-                            = AdvancedOrderTicket::null) = 0;
+                            = AdvancedOrderTicket::null,
+                        id_type client_id = 0,
+                        owner_type owner = 0) = 0;
 
     virtual id_type
     insert_stop_order(bool buy, 
@@ -201,7 +273,9 @@ public:
                       size_t size,
                       order_exec_cb_type exec_cb = nullptr,
                       const AdvancedOrderTicket& advanced
-                          = AdvancedOrderTicket::null) = 0;
+                          = AdvancedOrderTicket::null,
+                      id_type client_id = 0,
+                      owner_type owner = 0) = 0;
 
     virtual id_type
     insert_stop_order(bool buy, 
@@ -210,7 +284,9 @@ public:
                       size_t size, 
                       order_exec_cb_type exec_cb = nullptr,
                       const AdvancedOrderTicket& advanced
-                          = AdvancedOrderTicket::null) = 0;
+                          = AdvancedOrderTicket::null,
+                      id_type client_id = 0,
+                      owner_type owner = 0) = 0;
 
     virtual id_type
     replace_with_market_order(id_type id, 
@@ -244,7 +320,9 @@ public:
                               size_t size,
                               order_exec_cb_type exec_cb = nullptr,
                               const AdvancedOrderTicket& advanced
-                                  = AdvancedOrderTicket::null) = 0;
+                                  = AdvancedOrderTicket::null,
+                              id_type client_id = 0,
+                              owner_type owner = 0) = 0;
 
     virtual std::future<id_type>
     insert_stop_order_async(bool buy,
@@ -252,7 +330,9 @@ public:
                             size_t size,
                             order_exec_cb_type exec_cb = nullptr,
                             const AdvancedOrderTicket& advanced
-                                = AdvancedOrderTicket::null) = 0;
+                                = AdvancedOrderTicket::null,
+                            id_type client_id = 0,
+                            owner_type owner = 0) = 0;
 
     virtual std::future<id_type>
     insert_stop_order_async(bool buy,
@@ -261,7 +341,9 @@ public:
                             size_t size,
                             order_exec_cb_type exec_cb = nullptr,
                             const AdvancedOrderTicket& advanced
-                                = AdvancedOrderTicket::null) = 0;
+                                = AdvancedOrderTicket::null,
+                            id_type client_id = 0,
+                            owner_type owner = 0) = 0;
 
     virtual std::future<id_type>
     replace_with_market_order_async(id_type id,
@@ -290,6 +372,13 @@ public:
                                   const AdvancedOrderTicket& advanced
                                       = AdvancedOrderTicket::null) = 0;
 
+    /* all in one window; result[i] is for batch[i] (see OrderBatch) */
+    virtual std::vector<batch_result>
+    insert_orders(const OrderBatch& batch) = 0;
+
+    virtual std::future<std::vector<batch_result>>
+    insert_orders_async(const OrderBatch& batch) = 0;
+
     virtual void 
     dump_limits(std::ostream& out = std::cout) const = 0;
 
@@ -299,6 +388,20 @@ public:
     virtual void 
     dump_sell_limits(std::ostream& out = std::cout) const = 0;
 
+    /* {price: (buy stop size, sell stop size)} within 'depth' ticks of
+       the last trade; kept per level so it doesn't walk the stops */
+    virtual std::map<double, std::pair<size_t,size_t>>
+    stop_depth(size_t depth=8) const = 0;
+
+    virtual size_t
+    total_buy_stop_size() const = 0;
+
+    virtual size_t
+    total_sell_stop_size() const = 0;
+
+    virtual size_t
+    total_stop_size() const = 0;
+
     virtual void 
     dump_stops(std::ostream& out = std::cout) const = 0;
 
@@ -318,6 +421,80 @@ public:
     virtual void
     dump_aon_limits(std::ostream& out = std::cout) const = 0;
 
+    /*
+     * call 'visitor' w/ a level_view of each non-AON limit level of 'side'
+     * (both = bids, then asks), best price first, priced in [min_price,
+     * max_price] (0 = open), all under one lock; the visitor returns false
+     * to stop. Returns the number of levels visited.
+     *
+     * views are only valid for the call; DON'T call into the book from the
+     * visitor (it's holding the lock)
+     */
+    template<typename Visitor>
+    inline size_t
+    visit_levels( side_of_market side,
+                  double min_price,
+                  double max_price,
+                  Visitor&& visitor ) const
+    {
+        return _visit_levels(side, min_price, max_price,
+                             &_call_visitor<level_view, Visitor>,
+                             _visitor_arg(visitor));
+    }
+
+    /*
+     * same, w/ an order_view of each order of 'side', high price to low;
+     * at each price: limits(incl. AON) in time priority, then stops. Same
+     * 'type' matching as pull_filter
+     */
+    template<typename Visitor>
+    inline size_t
+    visit_orders( side_of_trade side,
+                  double min_price,
+                  double max_price,
+                  order_type type,
+                  Visitor&& visitor ) const
+    {
+        return _visit_orders(side, min_price, max_price, type,
+                             &_call_visitor<order_view, Visitor>,
+                             _visitor_arg(visitor));
+    }
+
+protected:
+    /* the visitor, type-erased w/o allocating */
+    template<typename ViewTy>
+    using visitor_fn_type = bool(*)(void*, const ViewTy&);
+
+    template<typename ViewTy, typename Visitor>
+    static bool
+    _call_visitor(void *visitor, const ViewTy& view)
+    {
+        using V = typename std::remove_reference<Visitor>::type;
+        return static_cast<bool>( (*static_cast<V*>(visitor))(view) );
+    }
+
+    template<typename Visitor>
+    static inline void*
+    _visitor_arg(Visitor& visitor)
+    {
+        return const_cast<void*>(
+            static_cast<const void*>(std::addressof(visitor)) );
+    }
+
+    virtual size_t
+    _visit_levels( side_of_market side,
+                   double min_price,
+                   double max_price,
+                   visitor_fn_type<level_view> visitor,
+                   void *arg ) const = 0;
+
+    virtual size_t
+    _visit_orders( side_of_trade side,
+                   double min_price,
+                   double max_price,
+                   order_type type,
+                   visitor_fn_type<order_view> visitor,
+                   void *arg ) const = 0;
 };
 
 class ManagementInterface
@@ -336,6 +513,148 @@ public:
 
     virtual void
     grow_book_below(double new_min) = 0;
+
+    /* how the secondary thread(s) wait for work; default is blocking */
+    virtual void
+    set_wait_strategy(wait_strategy ws,
+                      sob_thread thrd = sob_thread::both) = 0;
+
+    virtual wait_strategy
+    get_wait_strategy(sob_thread thrd = sob_thread::dispatcher) const = 0;
+
+    /*
+     * false if the OS call failed or isn't supported on this platform, or
+     * the book has no thread of its own (pooled or inline execution)
+     */
+    virtual bool
+    pin_thread(unsigned int cpu, sob_thread thrd = sob_thread::both) = 0;
+
+    virtual bool
+    name_thread(std::string name, sob_thread thrd = sob_thread::both) = 0;
+
+    /* # of levels per side kept in the depth snapshot; 0(default) = off */
+    virtual void
+    set_depth_snapshot_levels(size_t n) = 0;
+
+    virtual size_t
+    get_depth_snapshot_levels() const = 0;
+
+    /*
+     * L2 feed: at the end of every window that changes the book's
+     * (non-AON limit) depth, the levels that changed are written to 'ring'
+     * w/ the next sequence #; the first batch is the whole book as of the
+     * call. The caller owns 'ring' and must keep it alive until it's
+     * unsubscribed (false if it wasn't subscribed).
+     */
+    virtual void
+    subscribe_depth_deltas(DepthDeltaRing *ring) = 0;
+
+    virtual bool
+    unsubscribe_depth_deltas(DepthDeltaRing *ring) = 0;
+
+    /*
+     * L3 feed: every add(of an order that rests), cancel, modify, fill and
+     * stop trigger, in the order the engine does them, written to 'ring'
+     * when the window closes (see order_event); the first events are adds
+     * for every order in the book as of the call. Same ownership rules as
+     * subscribe_depth_deltas.
+     */
+    virtual void
+    subscribe_order_events(OrderEventRing *ring) = 0;
+
+    virtual bool
+    unsubscribe_order_events(OrderEventRing *ring) = 0;
+
+    /*
+     * time orders spend in the dispatcher's queue(s); pulls by (engine) order
+     * ID go in their own lane, ahead of everything else, so they're
+     * reported separately
+     */
+    virtual queue_time_stats
+    get_cancel_queue_time_stats() const = 0;
+
+    virtual queue_time_stats
+    get_order_queue_time_stats() const = 0;
+
+    virtual void
+    reset_queue_time_stats() = 0;
+
+    /*
+     * cap on the # of orders waiting for the dispatcher (0 = no cap, the
+     * default) and what happens to new ones when it's reached (see
+     * overflow_policy); orders already queued are never affected by a
+     * smaller cap
+     */
+    virtual void
+    set_queue_capacity(size_t n,
+                       overflow_policy policy = overflow_policy::block) = 0;
+
+    virtual size_t
+    get_queue_capacity() const = 0;
+
+    virtual overflow_policy
+    get_overflow_policy() const = 0;
+
+    /* # of orders waiting for the dispatcher right now */
+    virtual size_t
+    get_queue_depth() const = 0;
+
+    /* # of orders rejected or shed because the queue was full */
+    virtual unsigned long long
+    get_queue_rejections() const = 0;
+
+    /*
+     * coalesce replace storms(off by default): a replace or pull of an ID
+     * that arrives while an earlier replace of that ID is still queued
+     * supersedes it - the earlier one is never executed and returns
+     * superseded_id right away
+     */
+    virtual void
+    set_replace_coalescing(bool on) = 0;
+
+    virtual bool
+    get_replace_coalescing() const = 0;
+
+    /*
+     * the clock trades are stamped w/: any clock_source_type (e.g
+     * simulated_clock), or null for clock_type::now (the default);
+     * set_time(tp) stops the clock at 'tp' until it's set again
+     */
+    virtual void
+    set_clock(clock_source_type clock) = 0;
+
+    virtual void
+    set_time(clock_type::time_point tp) = 0;
+
+    /* read the clock once per window; all its trades get the same time */
+    virtual void
+    set_timestamp_per_window(bool on) = 0;
+
+    virtual bool
+    get_timestamp_per_window() const = 0;
+
+    /*
+     * keep OHLCV bars of 'interval' (e.g 1s, 1m, 5m) - updated by each fill
+     * as it happens, at the trade's timestamp - w/ the last 'history' of
+     * them available to bars(); adding one that's already kept resets it
+     */
+    virtual void
+    add_bar_interval(clock_type::duration interval, size_t history) = 0;
+
+    virtual bool
+    remove_bar_interval(clock_type::duration interval) = 0;
+
+    /* created w/ SimpleOrderbook::UseInlineExecution(true) */
+    virtual bool
+    is_inline() const = 0;
+
+    /*
+     * inline books only: append callbacks to 'buf' instead of running them
+     * (null, the default, runs them); the caller owns 'buf' and must keep
+     * it alive until it's unset
+     */
+    virtual void
+    set_inline_callback_buffer(std::vector<callback_event> *buf) = 0;
 };
 
 }; /* sob */
@@ -0,0 +1,168 @@
+/*
+Copyright (C) 2017 Jonathon Ogden < jeog.dev@gmail.com >
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see http://www.gnu.org/licenses.
+*/
+
+#ifndef JO_SOB_ORDER_BATCH
+#define JO_SOB_ORDER_BATCH
+
+#include <vector>
+#include <exception>
+
+#include "common.hpp"
+#include "advanced_order.hpp"
+
+namespace sob {
+
+/*
+ *   OrderBatch :
+ *
+ *      A contiguous list of new orders passed to insert_orders(_async).
+ *      The whole batch is queued as one element and executed, in order,
+ *      in ONE window: one queue push, one lock of the book, one delivery
+ *      of (sync) callbacks. Each order gets its own batch_result.
+ *
+ *   batch_result :
+ *
+ *      the order's ID, or 0 and the exception the equivalent insert_...
+ *      call would have thrown (the rest of the batch still executes)
+ */
+class OrderBatch {
+public:
+    struct entry {
+        order_type type; // limit, market, stop, or stop_limit
+        bool buy;
+        double limit;
+        double stop;
+        size_t size;
+        order_exec_cb_type exec_cb;
+        AdvancedOrderTicket advanced;
+        id_type client_id;
+        owner_type owner;
+    };
+
+    using const_iterator = std::vector<entry>::const_iterator;
+
+    OrderBatch() : _entries() {}
+
+    explicit OrderBatch(size_t reserve) : _entries()
+    { _entries.reserve(reserve); }
+
+    inline OrderBatch&
+    add_limit_order( bool buy,
+                     double limit,
+                     size_t size,
+                     order_exec_cb_type exec_cb = nullptr,
+                     const AdvancedOrderTicket& advanced
+                         = AdvancedOrderTicket::null,
+                     id_type client_id = 0,
+                     owner_type owner = 0 )
+    {
+        _entries.push_back( {order_type::limit, buy, limit, 0, size,
+                             exec_cb, advanced, client_id, owner} );
+        return *this;
+    }
+
+    inline OrderBatch&
+    add_market_order( bool buy,
+                      size_t size,
+                      order_exec_cb_type exec_cb = nullptr,
+                      const AdvancedOrderTicket& advanced
+                          = AdvancedOrderTicket::null,
+                      id_type client_id = 0,
+                      owner_type owner = 0 )
+    {
+        _entries.push_back( {order_type::market, buy, 0, 0, size,
+                             exec_cb, advanced, client_id, owner} );
+        return *this;
+    }
+
+    inline OrderBatch&
+    add_stop_order( bool buy,
+                    double stop,
+                    size_t size,
+                    order_exec_cb_type exec_cb = nullptr,
+                    const AdvancedOrderTicket& advanced
+                        = AdvancedOrderTicket::null,
+                    id_type client_id = 0,
+                    owner_type owner = 0 )
+    {
+        _entries.push_back( {order_type::stop, buy, 0, stop, size,
+                             exec_cb, advanced, client_id, owner} );
+        return *this;
+    }
+
+    inline OrderBatch&
+    add_stop_order( bool buy,
+                    double stop,
+                    double limit,
+                    size_t size,
+                    order_exec_cb_type exec_cb = nullptr,
+                    const AdvancedOrderTicket& advanced
+                        = AdvancedOrderTicket::null,
+                    id_type client_id = 0,
+                    owner_type owner = 0 )
+    {
+        _entries.push_back( {order_type::stop_limit, buy, limit, stop, size,
+                             exec_cb, advanced, client_id, owner} );
+        return *this;
+    }
+
+    inline size_t
+    size() const
+    { return _entries.size(); }
+
+    inline bool
+    empty() const
+    { return _entries.empty(); }
+
+    inline void
+    reserve(size_t n)
+    { _entries.reserve(n); }
+
+    inline void
+    clear()
+    { _entries.clear(); }
+
+    inline const entry&
+    operator[](size_t i) const
+    { return _entries[i]; }
+
+    inline const_iterator
+    begin() const
+    { return _entries.cbegin(); }
+
+    inline const_iterator
+    end() const
+    { return _entries.cend(); }
+
+private:
+    std::vector<entry> _entries;
+};
+
+
+struct batch_result {
+    id_type id; // 0 on failure
+    std::exception_ptr error;
+
+    batch_result() : id(0), error() {}
+
+    inline operator bool() const
+    { return id != 0; }
+};
+
+}; /* sob */
+
+#endif /* JO_SOB_ORDER_BATCH */
@@ -30,10 +30,13 @@ along with this program. If not, see http://www.gnu.org/licenses.
 #include <string>
 #include <tuple>
 #include <queue>
+#include <deque>
 #include <string>
 #include <ratio>
 #include <array>
 #include <thread>
+#include <atomic>
+#include <mutex>
 #include <future>
 #include <condition_variable>
 #include <chrono>
@@ -48,6 +51,7 @@ along with this program. If not, see http://www.gnu.org/licenses.
 #include "tick_price.hpp"
 #include "advanced_order.hpp"
 #include "order_paramaters.hpp"
+#include "worker_pool.hpp"
 
 #ifdef DEBUG
 #undef NDEBUG
@@ -100,6 +104,36 @@ namespace sob {
  *                              and orderbook between this range of doubles
  *
  *
+ *   SimpleOrderbook::UseDispatcherPool(nthreads) :
+ *
+ *      Orderbooks created (through any FactoryProxy) AFTER this call don't
+ *      get their own dispatcher thread; their orders are executed by a
+ *      shared pool of 'nthreads' workers (M books on N threads). A book
+ *      is only ever run by one worker at a time so orders still execute
+ *      in the order they were queued. Pass 0 to go back to a dedicated
+ *      thread per book. Existing books keep whatever they were created with.
+ *
+ *
+ *   SimpleOrderbook::UseCallbackPool(nthreads) :
+ *
+ *      Same idea for the async callback thread: new books' async callbacks
+ *      are run by a shared pool of 'nthreads' workers. Each book's pending
+ *      callbacks are run as one batch, in order, by one worker at a time;
+ *      a book w/ more waiting goes to the back of the run queue.
+ *
+ *
+ *   SimpleOrderbook::UseInlineExecution(on, this_thread_only) :
+ *
+ *      Orderbooks created AFTER this call(w/ on = true) - by any thread, or
+ *      just the calling one w/ this_thread_only = true - have no dispatcher
+ *      or async callback thread: each order is executed on the caller's
+ *      thread, in the call, and its callbacks - sync AND async - are run
+ *      right after the window closes (or collected, see
+ *      set_inline_callback_buffer). Same fills and IDs as a threaded book
+ *      fed the same orders, w/o the queue, wake-ups and thread hand-offs;
+ *      for backtests/simulation. The _async calls return ready futures.
+ *
+ *
  *   UtilityInterface :
  *
  *      tick, price, and memory info
@@ -120,7 +154,9 @@ namespace sob {
  *
  *   ManagementInterface :
  *
- *      advanced control and diagnostic features (e.g grow the orderbook)
+ *      advanced control and diagnostic features (e.g grow the orderbook,
+ *      set how the dispatcher/callback threads wait for work, pin them to
+ *      cores and name them)
  *
  *
  *   order_exec_cb_type :
@@ -129,6 +165,23 @@ namespace sob {
  *      execution, cancellation, or advanced order action occurs. STOP-LIMITS
  *      AND CERTAIN ADVANCED ORDERS NEED TO KEEP TRACK OF THE TWO 'id_type'
  *      ARGS FOR CHANGES IN ORDER ID# WHEN CERTAIN CONDITIONS ARE TRIGGERED.
+ *
+ *   client_id :
+ *
+ *      an optional ID (built w/ make_client_id) passed to the insert methods
+ *      that can be used IN PLACE OF the order ID by pull/replace and
+ *      get_order_info. Because it's known before the insert is executed
+ *      insert -> replace -> pull can be pipelined w/o waiting on futures.
+ *      A replace moves the client ID to the new order, as does a triggered
+ *      stop. Callbacks still receive engine order IDs.
+ *
+ *   owner :
+ *
+ *      an optional tag (e.g a session) passed to the insert methods; the
+ *      book keeps a list of each owner's live orders - including those
+ *      created by replaces, triggered stops and advanced orders - so
+ *      pull_all(owner, filter) can cancel them (by side, price range and/or
+ *      order type) in ONE window, w/ the cancel callbacks delivered together.
  */
 
 namespace detail {
@@ -151,10 +204,223 @@ namespace detail {
     template<typename T> struct promise_helper;
 };
 
+
+/* one changed level (see ManagementInterface::subscribe_depth_deltas) */
+struct depth_delta {
+    unsigned long long seq; // same for every level changed in a window
+    side_of_market side; // bid or ask
+    double price;
+    size_t size; // new aggregate size; 0 = nothing left at this price/side
+
+    depth_delta();
+    depth_delta(unsigned long long seq, side_of_market side, double price,
+                size_t size);
+};
+
+/*
+ * one price level of a flat depth query (see FullInterface::bid_depth_levels);
+ * non-AON limit orders only, same as bid_depth/ask_depth
+ */
+struct depth_level {
+    double price;
+    size_t size;
+    size_t count; // # of orders
+};
+
+/* one price level passed to a visit_levels visitor (see FullInterface) */
+struct level_view {
+    double price;
+    long long tick; // price / tick_size
+    side_of_market side; // bid or ask
+    size_t size; // non-AON limits only, same as bid_depth/ask_depth
+    size_t count; // # of orders
+};
+
+/* one order passed to a visit_orders visitor (see FullInterface) */
+struct order_view {
+    id_type id;
+    double limit; // 0 = none
+    double stop; // 0 = none
+    long long tick; // price / tick_size it rests at(a stop's stop price)
+    size_t size; // remaining
+    order_type type; // limit(incl. AON), stop or stop_limit
+    bool is_buy;
+    order_condition condition;
+    condition_trigger trigger;
+};
+
+/*
+ * one event for one order (see ManagementInterface::subscribe_order_events);
+ * fixed-size and trivially copyable so it can be copied/written out as is
+ */
+struct order_event {
+    id_type id;
+    id_type parent_id; /* add: the order it replaced/came from(stop, modify)
+                          fill: the other side of the trade
+                          stop_trigger: the order the stop became */
+    long long tick; // price / tick_size; a stop's stop price
+    size_t size; // add/cancel: size left; modify: new size; fill: amount
+    unsigned long long window; // top_of_book::window it's published w/
+    order_event_type type;
+    bool buy;
+    order_type order; // limit(incl. AON), stop or stop_limit; null for fills
+};
+
+/*
+ * single-producer(the book)/single-consumer ring a subscriber hands to
+ * subscribe_depth_deltas (DepthDeltaRing) or subscribe_order_events
+ * (OrderEventRing); a window's records become visible together when it
+ * closes. If the consumer falls behind and the ring fills up the rest
+ * spill into an overflow buffer (under a mutex) until it's drained, so
+ * nothing is ever dropped and the book never waits on the consumer.
+ */
+template<typename T>
+class FeedRing {
+public:
+    using value_type = T;
+
+    /* rounded up to a power of 2 */
+    explicit FeedRing(size_t capacity = 4096)
+        :
+            _ring(),
+            _write(0),
+            _read_cached(0),
+            _published(0),
+            _read(0),
+            _pending(),
+            _overflow(),
+            _overflowed(false),
+            _overflow_mtx(),
+            _subscribed(false)
+        {
+            size_t n = 1;
+            while( n < capacity )
+                n <<= 1;
+            _ring.resize(n);
+        }
+
+    FeedRing(const FeedRing& ring) = delete;
+    FeedRing& operator=(const FeedRing& ring) = delete;
+
+    /* append everything published so far, in order, to 'out'; returns # */
+    size_t
+    pop(std::vector<T>& out);
+
+    bool
+    empty() const
+    {
+        return _published.load() == _read.load(std::memory_order_relaxed)
+            && !_overflowed.load();
+    }
+
+    inline size_t
+    capacity() const
+    { return _ring.size(); }
+
+private:
+    friend class SimpleOrderbook;
+
+    std::vector<T> _ring;
+    size_t _write; // producer only
+    size_t _read_cached; // producer only
+    std::atomic<size_t> _published;
+    std::atomic<size_t> _read;
+    std::vector<T> _pending; // producer only, spilled this window
+    std::vector<T> _overflow;
+    std::atomic<bool> _overflowed;
+    std::mutex _overflow_mtx;
+    bool _subscribed;
+
+    /* called by the book (w/ _master_mtx held); not visible until _publish */
+    inline void
+    _push(const T& t)
+    {
+        size_t w = _write;
+        if( _pending.empty() && !_overflowed.load(std::memory_order_relaxed) ){
+            if( w - _read_cached >= _ring.size() )
+                _read_cached = _read.load(std::memory_order_acquire);
+            if( w - _read_cached < _ring.size() ){
+                _ring[w & (_ring.size() - 1)] = t;
+                _write = w + 1;
+                return;
+            }
+        }
+        _pending.push_back(t);
+    }
+
+    void
+    _publish();
+};
+
+
+/*
+ * the book doesn't write to the ring while the overflow buffer is in use,
+ * so everything published before we see it comes first
+ */
+template<typename T>
+size_t
+FeedRing<T>::pop(std::vector<T>& out)
+{
+    size_t end;
+    std::vector<T> overflow;
+    if( _overflowed.load() ){
+        std::lock_guard<std::mutex> lock(_overflow_mtx);
+        end = _published.load();
+        overflow.swap(_overflow);
+        _overflowed = false;
+    }else
+        end = _published.load();
+
+    size_t r = _read.load(std::memory_order_relaxed);
+    size_t n = (end - r) + overflow.size();
+    out.reserve(out.size() + n);
+    for( ; r != end; ){
+        out.push_back( _ring[r & (_ring.size() - 1)] );
+        _read.store(++r, std::memory_order_release);
+    }
+    out.insert(out.end(), overflow.begin(), overflow.end());
+    return n;
+}
+
+
+// called by the book (w/ _master_mtx held) when a window closes
+template<typename T>
+void
+FeedRing<T>::_publish()
+{
+    if( _pending.empty() ){
+        _published.store(_write);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_overflow_mtx);
+        _published.store(_write);
+        _overflow.insert(_overflow.end(), _pending.begin(), _pending.end());
+        _overflowed = true;
+    }
+    _pending.clear();
+}
+
+
 class SimpleOrderbook {
     class ImplDeleter;
     static SOB_RESOURCE_MANAGER<FullInterface, ImplDeleter> master_rmanager;
 
+    /* pools new books are scheduled on (null = dedicated thread) */
+    static std::shared_ptr<WorkerPool> dispatcher_pool;
+    static std::shared_ptr<WorkerPool> callback_pool;
+    static std::mutex pools_mtx;
+
+    /* new books execute orders on the caller's thread */
+    static std::atomic<bool> inline_execution;
+    static thread_local bool inline_execution_this_thread;
+
+    static std::shared_ptr<WorkerPool>
+    dispatcher_pool_in_use();
+
+    static std::shared_ptr<WorkerPool>
+    callback_pool_in_use();
+
 public:
     template<typename... TArgs>
     struct create_func_varargs{
@@ -242,6 +508,27 @@ public:
     IsManaged(FullInterface *interface)
     { return master_rmanager.is_managed(interface); }
 
+    static void
+    UseDispatcherPool(unsigned int nthreads);
+
+    /* 0 if new books get a dedicated dispatcher thread */
+    static unsigned int
+    DispatcherPoolSize();
+
+    static void
+    UseCallbackPool(unsigned int nthreads);
+
+    /* 0 if new books get a dedicated async callback thread */
+    static unsigned int
+    CallbackPoolSize();
+
+    /* 'this_thread_only' = just books created by the calling thread */
+    static void
+    UseInlineExecution(bool on, bool this_thread_only = false);
+
+    static bool
+    InlineExecution();
+
     friend struct detail::sob_types;
 
 
@@ -262,6 +549,7 @@ private:
 
             order_exec_cb_type cb_obj;
             type cb_type;
+            owner_type owner; // travels w/ the order (and what it triggers)
 
             operator bool() const { return cb_obj.operator bool(); }
             bool is_synchronous() const { return cb_type == type::synchronous; }
@@ -285,27 +573,61 @@ private:
             order_queue_elem_base_();
         };
 
-        struct dfrd_cb_elem;
+        using dfrd_cb_elem = callback_event;
         using callback_queue_type = std::deque<dfrd_cb_elem>;
+        using callback_buffer_type = std::vector<dfrd_cb_elem>;
 
-        /* order info passed to external/execution queue */
-        struct external_order_queue_elem
+        /* order info as passed in by the caller */
+        struct external_order
                 : public order_queue_elem_base_{
             AdvancedOrderTicket aot;
+            id_type client_id;
+
+            external_order( ORDER_QUEUE_ELEM_BASE_ARGS,
+                            const AdvancedOrderTicket& aot,
+                            id_type client_id );
+            external_order();
+        };
+
+        /*
+         * an OrderBatch queued as ONE external elem; the dispatcher fills
+         * in 'results' and, for insert_orders_async, fulfills 'promise'
+         */
+        struct order_batch_bndl{
+            std::vector<external_order> orders;
+            std::vector<batch_result> results;
+            std::promise<std::vector<batch_result>> promise;
+        };
+
+        /* order info passed to external/execution queue */
+        struct external_order_queue_elem
+                : public external_order{
+            std::shared_ptr<order_batch_bndl> batch;
+            std::unique_ptr<pull_filter> filter; // pull_all(cb.owner, *filter)
+            clock_type::time_point queued_at;
+            bool superseded; // already completed, skip when popped
 
             union{
                 std::promise<id_type> promise_async;
-                std::promise<std::pair<id_type, callback_queue_type>> promise_sync;
+                std::promise<std::pair<id_type, callback_buffer_type>> promise_sync;
             };
 
             external_order_queue_elem( ORDER_QUEUE_ELEM_BASE_ARGS,
                                        const AdvancedOrderTicket& aot,
-                                       std::promise<id_type>&& promise );
+                                       id_type client_id,
+                                       std::promise<id_type>&& promise,
+                                       std::shared_ptr<order_batch_bndl> batch
+                                           = nullptr,
+                                       std::unique_ptr<pull_filter>&& filter
+                                           = nullptr );
 
             external_order_queue_elem(
                 ORDER_QUEUE_ELEM_BASE_ARGS,
                 const AdvancedOrderTicket& aot,
-                std::promise<std::pair<id_type, callback_queue_type>>&& promise
+                id_type client_id,
+                std::promise<std::pair<id_type, callback_buffer_type>>&& promise,
+                std::shared_ptr<order_batch_bndl> batch = nullptr,
+                std::unique_ptr<pull_filter>&& filter = nullptr
                 );
 
             external_order_queue_elem();
@@ -345,7 +667,7 @@ private:
                 id_type parent_id = 0
                 );
 
-            order_queue_elem(const external_order_queue_elem& e,
+            order_queue_elem(const external_order& e,
                              const SimpleOrderbookBase* sob);
         };
 
@@ -482,26 +804,6 @@ private:
                 : order_link(id, is_primary), nticks(nticks) {}
         };
 
-        /* info held for each exec callback in the deferred callback vector*/
-        struct dfrd_cb_elem{
-            callback_msg msg;
-            order_exec_cb_type exec_cb;
-            id_type id1;
-            id_type id2;
-            double price;
-            size_t sz;
-            dfrd_cb_elem(callback_msg msg, const order_exec_cb_type& exec_cb,
-                         id_type id1, id_type id2, double price, size_t sz)
-                : msg(msg), exec_cb(exec_cb), id1(id1), id2(id2),
-                  price(price), sz(sz)
-                {}
-            dfrd_cb_elem()
-                : msg(callback_msg::cancel), exec_cb(nullptr), id1(0), id2(0),
-                  price(0.0), sz(0)
-                {}
-        };
-
-
         /* holds all limit orders at a price */
         using limit_chain_type = std::list<limit_bndl>;
 
@@ -568,6 +870,15 @@ private:
             chain_manager<aon_chain_type> aon_buys;
             chain_manager<aon_chain_type> aon_sells;
 
+            /* aggregate size of the buy/sell stops in 'stops' */
+            size_t buy_stop_size = 0;
+            size_t sell_stop_size = 0;
+
+            /* what the depth-delta feed last published for this level */
+            size_t l2_size = 0;
+            bool l2_bid = false;
+            bool l2_dirty = false;
+
             level() = default;
             level( const level& ) = delete;
             level& operator=( const level& ) = delete;
@@ -589,6 +900,10 @@ private:
                              );
         ~SimpleOrderbookBase();
 
+        /* no threads/queue, orders run on the caller's thread */
+        const bool _inline_exec;
+        std::vector<callback_event> *_inline_callback_buffer;
+
          /* THE ORDER BOOK */
         std::vector<level> _book;
 
@@ -609,6 +924,10 @@ private:
         plevel _low_sell_aon;
         plevel _high_sell_aon;
 
+        /* sum of every level's buy/sell_stop_size */
+        size_t _total_buy_stop_size;
+        size_t _total_sell_stop_size;
+
         struct chain_iter_wrap {
         private:
             _order_bndl& _get_base_bndl() const;
@@ -675,6 +994,21 @@ private:
         std::set<id_type> _trailing_sell_stops;
         std::set<id_type> _trailing_buy_stops;
 
+        /*
+         * client-assigned ids -> engine ids (and back); entries for orders
+         * that leave the book by paths that don't clean up are validated
+         * against _id_cache (and dropped) on lookup
+         */
+        std::unordered_map<id_type, id_type> _client_ids;
+        std::unordered_map<id_type, id_type> _client_ids_by_order;
+
+        /*
+         * live orders of each owner, oldest(lowest id) first; bound when an
+         * order goes into a chain, erased when it's filled/pulled/triggered
+         * and, like client ids, validated against _id_cache on lookup
+         */
+        std::unordered_map<owner_type, std::set<id_type>> _owner_orders;
+
         unsigned long long _total_volume;
         id_type _last_id;
         size_t _last_size;
@@ -682,17 +1016,152 @@ private:
         /* time & sales */
         std::vector<timesale_entry_type> _timesales;
 
-        /* synchronous(manual) callbacks */
-        callback_queue_type _callbacks_sync;
+        /*
+         * bars: for each interval the last 'history' bars in a ring, the
+         * newest (still open) one updated in place by every fill
+         */
+        struct bar_series {
+            clock_type::duration interval;
+            std::vector<bar> bars;
+            size_t next; // where the next new bar goes
+            size_t count;
+            double notional; // price * size of the newest bar (for vwap)
+            bar_series(clock_type::duration interval, size_t history);
+        };
+        std::vector<bar_series> _bar_series;
+
+        /*
+         * trade timestamps: _clock (null = clock_type::now), read at most
+         * once a window w/ _timestamp_per_window (_window_time is
+         * invalidated as each window opens)
+         */
+        clock_source_type _clock;
+        bool _timestamp_per_window;
+        bool _window_time_valid;
+        clock_type::time_point _window_time;
+
+        /*
+         * top-of-book published by the dispatcher (seqlock) at the end of
+         * each window so the basic query methods don't need _master_mtx;
+         * (odd seq = write in progress). Padded, not alignas'd, because
+         * pre-C++17 'new' ignores extended alignment.
+         */
+        struct top_of_book_record {
+            char _pad_front[64]; // keep readers off neighbors' cache lines
+            std::atomic<unsigned long long> seq;
+            std::atomic<double> bid_price;
+            std::atomic<size_t> bid_size;
+            std::atomic<double> ask_price;
+            std::atomic<size_t> ask_size;
+            std::atomic<double> last_price;
+            std::atomic<size_t> last_size;
+            std::atomic<unsigned long long> volume;
+            std::atomic<id_type> last_id;
+            std::atomic<unsigned long long> window;
+            char _pad_back[64];
+            top_of_book_record();
+        };
+        top_of_book_record _top_of_book;
+
+        /*
+         * top-N depth, republished (only if it changed) by the dispatcher
+         * at the end of a window into whichever of the two buffers readers
+         * aren't using; readers pin the current buffer w/ a count and copy
+         * it out w/o touching _master_mtx
+         */
+        using depth_level_type = std::pair<double, size_t>; // price, size
+        struct depth_snapshot_buffer {
+            std::vector<depth_level_type> bids;
+            std::vector<depth_level_type> asks;
+            unsigned long long window;
+            mutable std::atomic<unsigned int> readers;
+            depth_snapshot_buffer();
+        };
+        depth_snapshot_buffer _depth_snapshots[2];
+        std::atomic<int> _depth_snapshot_current;
+        size_t _depth_snapshot_levels;
+        std::vector<depth_level_type> _depth_scratch_bids;
+        std::vector<depth_level_type> _depth_scratch_asks;
+
+        /*
+         * depth-delta feed: while anyone's subscribed, levels whose limit
+         * chain is touched during a window are collected (once each) and
+         * at the end of the window the ones whose aggregate changed are
+         * written to every subscriber's ring w/ the next sequence #
+         */
+        std::vector<DepthDeltaRing*> _depth_subscribers;
+        std::vector<plevel> _depth_dirty;
+        unsigned long long _depth_delta_seq;
+
+        /*
+         * L3 feed: while anyone's subscribed every add/cancel/modify/fill/
+         * stop-trigger is written to each subscriber's ring as it happens
+         * and the window's events are published together when it closes
+         */
+        std::vector<OrderEventRing*> _order_event_subscribers;
+        id_type _order_event_parent; // of the order being inserted
+        bool _order_events_unpublished;
+        long long _beg_tick; // tick # of _beg (see order_event::tick)
 
-        /* container, thread, and sync for asynchronous callbacks */
-        callback_queue_type _callbacks_async;
+        /*
+         * synchronous(manual) callbacks; at the end of a window the buffer
+         * is swapped (not copied) into the caller's promise and the caller
+         * hands it back when it's done, so steady-state windows allocate
+         * nothing (buffers are reserved to the high-water mark)
+         */
+        static constexpr size_t MAX_RECYCLED_CALLBACK_BUFFERS = 8;
+        callback_buffer_type _callbacks_sync;
+        size_t _callbacks_sync_high_water;
+        std::vector<callback_buffer_type> _callback_buffers;
+        std::mutex _callback_buffers_mtx;
+
+        /*
+         * single-producer(dispatcher)/single-consumer(callback thread) ring
+         * for asynchronous callbacks; the dispatcher writes a window's
+         * callbacks w/o locking and publishes them once, when the window
+         * closes. If the ring fills up the rest go to _callbacks_async
+         * (under the mutex) until the callback thread drains it.
+         */
+        static constexpr size_t ASYNC_CALLBACK_RING_SIZE = 1024; // power of 2
+        std::vector<dfrd_cb_elem> _async_callback_ring;
+        size_t _async_callback_ring_write; // dispatcher only
+        std::atomic<size_t> _async_callback_ring_published;
+        std::atomic<size_t> _async_callback_ring_read;
+        std::atomic<bool> _async_callbacks_overflow;
+        callback_queue_type _callbacks_async; // overflow
+
+        /* for wait_for_async_callbacks */
+        std::atomic<unsigned long long> _async_callbacks_issued;
+        std::atomic<unsigned long long> _async_callbacks_executed;
 
         mutable std::mutex _async_callback_mtx;
         std::condition_variable _async_callback_cond;
         std::condition_variable _async_callback_done_cond;
-        volatile bool _async_callbacks_done;
+        std::atomic<bool> _async_callback_thread_waiting;
+        std::atomic<wait_strategy> _async_callback_wait;
+
+        /*
+         * w/ a callback pool there's no callback thread; publishing
+         * schedules _pooled_callback_executor (at most once, via
+         * _async_callbacks_scheduled) to run a batch on the pool, and the
+         * NULL callback fulfills _async_callbacks_stopped instead of
+         * ending the thread
+         */
+        class PoolTask
+                : public WorkerPool::Task {
+            SimpleOrderbookBase *_sob;
+            bool (SimpleOrderbookBase::*_run)();
+        public:
+            PoolTask(SimpleOrderbookBase *sob, bool (SimpleOrderbookBase::*run)())
+                : _sob(sob), _run(run) {}
+            bool run() { return (_sob->*_run)(); }
+        };
+        std::shared_ptr<WorkerPool> _callback_pool;
+        PoolTask _pooled_callback_executor;
+        std::atomic<bool> _async_callbacks_scheduled;
+        std::promise<void> _async_callbacks_stopped;
 
+        /* starts/stops the callback thread (or the pooled equivalent) */
         class AsyncCallbackThreadGuard {
             SimpleOrderbookBase *_sob;
             std::thread _t;
@@ -702,9 +1171,62 @@ private:
         };
 
         /* async order queue and sync objects */
-        std::queue<external_order_queue_elem> _external_order_queue;
+        std::deque<external_order_queue_elem> _external_order_queue;
         mutable std::mutex _external_order_queue_mtx;
         std::condition_variable _external_order_queue_cond;
+        std::atomic<bool> _external_orders_pending; // for spinning w/o lock
+        std::atomic<wait_strategy> _dispatcher_wait;
+
+        /*
+         * admission control for both lanes (_external_order_queue_mtx);
+         * pushers blocked on a full queue wait on _queue_space_cond, which
+         * the dispatcher signals as it pops (only if someone is waiting)
+         */
+        size_t _queue_capacity; // 0 = unbounded
+        overflow_policy _overflow_policy;
+        unsigned long long _queue_rejections;
+        size_t _blocked_pushers;
+        std::condition_variable _queue_space_cond;
+
+        /*
+         * pulls by engine ID (the order is live, nothing behind it in the
+         * queue can depend on it still being there) go in their own lane
+         * that's always drained first - but no more than CANCEL_LANE_BURST
+         * in a row while other orders are waiting. Pulls by client ID and
+         * pull_all stay in line w/ the inserts they can be pipelined behind.
+         */
+        static constexpr size_t CANCEL_LANE_BURST = 16;
+        std::queue<external_order_queue_elem> _cancel_order_queue;
+        size_t _cancels_in_a_row;
+
+        /*
+         * replaces still waiting in _external_order_queue, by the ID they
+         * replace (deque elems don't move on push/pop at the ends); ones
+         * that get superseded stay in the queue, marked, until popped
+         */
+        bool _coalesce_replaces;
+        std::unordered_map<id_type, external_order_queue_elem*> _queued_replaces;
+        size_t _superseded_in_queue;
+
+        /* push -> dispatch times per lane (_master_mtx) */
+        queue_time_stats _cancel_queue_times;
+        queue_time_stats _order_queue_times;
+
+        /*
+         * cpu/name requested for the secondary threads; the async callback
+         * thread is started by the dispatcher so we hold on to the request
+         * and apply it when (if) that thread shows up
+         */
+        struct thread_config{
+            int cpu; // -1 = not pinned
+            std::string name;
+            thread_config() : cpu(-1), name() {}
+        };
+        thread_config _dispatcher_config;
+        thread_config _async_callback_config;
+        std::thread::native_handle_type _async_callback_thread_handle;
+        bool _async_callback_thread_live;
+        std::mutex _thread_config_mtx;
 
         /* sync order queue for internal entry */
         std::queue<order_queue_elem> _internal_order_queue;
@@ -720,6 +1242,19 @@ private:
         /* async order queu thread */
         std::thread _order_dispatcher_thread;
 
+        /*
+         * if we were created w/ a dispatcher pool there's no dispatcher
+         * thread; pushes schedule _pooled_dispatcher on the pool (at most
+         * once, via _dispatcher_scheduled) and it executes a slice of the
+         * queue at a time. The async callback thread is owned here, instead
+         * of by the dispatcher, until the book is destroyed.
+         */
+        static constexpr size_t POOLED_DISPATCH_SLICE = 64;
+        std::shared_ptr<WorkerPool> _dispatcher_pool;
+        PoolTask _pooled_dispatcher;
+        std::atomic<bool> _dispatcher_scheduled;
+        std::unique_ptr<AsyncCallbackThreadGuard> _pooled_async_callback_thread;
+
         std::function<double(plevel)> _itop;
         std::function<plevel(double)> _ptoi;
         std::function<long long(double, double)> _ticks_in_range;
@@ -817,17 +1352,84 @@ private:
         void
         _threaded_order_dispatcher();
 
+        /* same, for a slice of the queue, when run by a dispatcher pool */
+        bool
+        _pooled_order_dispatcher();
+
+        void
+        _schedule_pooled_dispatcher();
+
+        /* next elem, cancel lane first (_external_order_queue_mtx held) */
+        bool
+        _pop_external_order(external_order_queue_elem& e);
+
+        size_t
+        _queue_depth() const
+        {
+            return _external_order_queue.size() + _cancel_order_queue.size()
+                   - _superseded_in_queue;
+        }
+
+        /* complete (w/ superseded_id) any replace of 'id' still queued */
+        bool
+        _supersede_queued_replace(id_type id);
+
+        /* drop from _queued_replaces before 'e' leaves the queue */
+        void
+        _forget_queued_replace(const external_order_queue_elem& e);
+
+        /* make room for a new elem per _overflow_policy; may block/throw */
+        void
+        _admit_external_order(std::unique_lock<std::mutex>& lock,
+                              bool priority_cancel);
+
+        /* fail a queued elem that will never be executed */
+        static void
+        _fail_external_order(external_order_queue_elem& e,
+                             std::exception_ptr error);
+
+        void
+        _record_queue_time(const external_order& e,
+                           clock_type::time_point queued_at);
+
+        void
+        _stop_pooled_dispatcher();
+
         template<typename T>
         void
         _dispatch_external_order( const external_order_queue_elem& ee,
                                   std::promise<T>&& promise );
 
+        /*
+         * one window (under _master_mtx), published when it closes; the
+         * sync callbacks are swapped into 'sync_callbacks' (if not null).
+         * 'queued_at' is a default time_point if the order was never queued
+         */
+        id_type
+        _execute_window( const external_order& e,
+                         order_batch_bndl *batch,
+                         const pull_filter *filter,
+                         clock_type::time_point queued_at,
+                         callback_buffer_type *sync_callbacks );
+
+        /* run (or collect into _inline_callback_buffer) on the caller's thread */
+        void
+        _deliver_sync_callbacks(callback_buffer_type&& callbacks);
+
         id_type
-        _execute_external_order(const external_order_queue_elem& e);
+        _execute_external_order(const external_order& e);
+
+        /* the whole batch in the current window; returns # of orders */
+        id_type
+        _execute_order_batch(order_batch_bndl& bndl);
+
+        std::shared_ptr<order_batch_bndl>
+        _build_order_batch(const OrderBatch& batch,
+                           order_exec_cb_bndl::type cb_type) const;
 
         /* all order types go through here */
         void
-        _insert_order(order_queue_elem& e);
+        _insert_order(order_queue_elem& e, id_type event_parent = 0);
 
         /* if we need immediate (partial/full) fill info for basic order type*/
         bool
@@ -857,23 +1459,33 @@ private:
                    plevel plev,
                    id_type id,
                    size_t size,
-                   const order_exec_cb_bndl& exec_cb);
+                   const order_exec_cb_bndl& exec_cb,
+                   bool buy);
 
         std::pair<size_t, bool>
         _hit_aon_chain(aon_chain_type *achain,
                        plevel plev,
                        id_type id,
                        size_t size,
-                       const order_exec_cb_bndl& exec_cb );
+                       const order_exec_cb_bndl& exec_cb,
+                       bool buy);
+
+        /* time for a trade (_master_mtx held) */
+        clock_type::time_point
+        _trade_time();
+
+        void
+        _update_bars(clock_type::time_point tp, double price, size_t size);
 
         /* DONT INSERT NEW TRADES IN HERE! */
         void
         _trade_has_occured(plevel plev,
                            size_t size,
-                           id_type idbuy,
-                           id_type idsell,
-                           const order_exec_cb_bndl& cbbuy,
-                           const order_exec_cb_bndl& cbsell);
+                           id_type id1,
+                           id_type id2,
+                           const order_exec_cb_bndl& cb1,
+                           const order_exec_cb_bndl& cb2,
+                           bool buy1);
 
         template<bool IsBuy>
         size_t
@@ -994,12 +1606,146 @@ private:
         void
         _push_async_callback(Args&&... args);
 
+        void
+        _publish_async_callbacks();
+
+        void
+        _publish_top_of_book();
+
+        top_of_book
+        _read_top_of_book() const;
+
+        void
+        _publish_depth_snapshot(bool force = false);
+
+        inline void
+        _depth_touch(plevel p)
+        {
+            if( !_depth_subscribers.empty() && !p->l2_dirty ){
+                p->l2_dirty = true;
+                _depth_dirty.push_back(p);
+            }
+        }
+
+        /* resize a resting order in place (use instead of iwrap.incr/decr_size) */
+        inline void
+        _incr_size(chain_iter_wrap& iwrap, size_t sz)
+        {
+            if( iwrap.is_limit() )
+                _depth_touch(iwrap.p);
+            else if( iwrap.is_stop() )
+                _stop_size_change(iwrap.p, iwrap.s_iter->is_buy, sz, true);
+            iwrap.incr_size(sz);
+            if( !_order_event_subscribers.empty() )
+                _order_resized_event(iwrap);
+        }
+
+        inline void
+        _decr_size(chain_iter_wrap& iwrap, size_t sz)
+        {
+            if( iwrap.is_limit() )
+                _depth_touch(iwrap.p);
+            else if( iwrap.is_stop() )
+                _stop_size_change(iwrap.p, iwrap.s_iter->is_buy, sz, false);
+            iwrap.decr_size(sz);
+            if( !_order_event_subscribers.empty() )
+                _order_resized_event(iwrap);
+        }
+
+        void
+        _publish_depth_deltas();
+
+        /* keep the stop aggregates in line w/ every stop added/removed */
+        inline void
+        _stop_size_change(plevel p, bool buy, size_t sz, bool add)
+        {
+            size_t& lev = buy ? p->buy_stop_size : p->sell_stop_size;
+            size_t& tot = buy ? _total_buy_stop_size : _total_sell_stop_size;
+            if( add ){
+                lev += sz;
+                tot += sz;
+            }else{
+                assert( sz <= lev && sz <= tot );
+                lev -= sz;
+                tot -= sz;
+            }
+        }
+
+        /* tick # of a level (see order_event::tick) */
+        inline long long
+        _tick(plevel p) const
+        { return _beg_tick + (p - _beg); }
+
+        inline void
+        _order_event( order_event_type type,
+                      id_type id,
+                      bool buy,
+                      plevel p,
+                      size_t sz,
+                      order_type ot,
+                      id_type parent = 0 )
+        {
+            if( _order_event_subscribers.empty() )
+                return;
+            order_event e;
+            e.id = id;
+            e.parent_id = parent;
+            e.tick = p ? _tick(p) : 0;
+            e.size = sz;
+            e.window = _top_of_book.window.load(std::memory_order_relaxed) + 1;
+            e.type = type;
+            e.buy = buy;
+            e.order = ot;
+            for( OrderEventRing *r : _order_event_subscribers )
+                r->_push(e);
+            _order_events_unpublished = true;
+        }
+
+        void
+        _publish_order_events();
+
+        void
+        _snapshot_order_events(OrderEventRing *ring);
+
+        /* modify event w/ the (in place) new size */
+        void
+        _order_resized_event(chain_iter_wrap& iwrap);
+
+        callback_buffer_type
+        _take_callback_buffer();
+
+        void
+        _recycle_callback_buffer(callback_buffer_type&& buf);
+
+        bool
+        _async_callbacks_ready() const;
+
         void
         _threaded_async_callback_executor();
 
+        bool
+        _pooled_async_callback_executor();
+
+        void
+        _schedule_pooled_callbacks();
+
+        void /* _async_callback_mtx must be held */
+        _take_async_callbacks(size_t& end, callback_queue_type& overflow);
+
+        bool
+        _run_async_callbacks(size_t end, callback_queue_type& overflow);
+
         void
         _notify_async_callbacks_done();
 
+        template<typename F>
+        bool
+        _configure_thread(sob_thread thrd, F apply);
+
+        bool
+        _apply_thread_config(sob_thread thrd,
+                             std::thread::native_handle_type handle);
+
         void
         _look_for_triggered_stops();
 
@@ -1040,7 +1786,13 @@ private:
                                    size_t size,
                                    order_exec_cb_type exec_cb,
                                    const AdvancedOrderTicket& aot,
-                                   id_type id = 0);
+                                   id_type id = 0,
+                                   id_type client_id = 0,
+                                   owner_type owner = 0,
+                                   std::shared_ptr<order_batch_bndl> batch
+                                       = nullptr,
+                                   std::unique_ptr<pull_filter>&& filter
+                                       = nullptr);
 
         /* push order onto the external queue, DON'T BLOCK */
         std::future<id_type>
@@ -1051,7 +1803,13 @@ private:
                                    size_t size,
                                    order_exec_cb_type exec_cb,
                                    const AdvancedOrderTicket& aot,
-                                   id_type id = 0);
+                                   id_type id = 0,
+                                   id_type client_id = 0,
+                                   owner_type owner = 0,
+                                   std::shared_ptr<order_batch_bndl> batch
+                                       = nullptr,
+                                   std::unique_ptr<pull_filter>&& filter
+                                       = nullptr);
 
         /* backend insert into queue */
         template<typename T>
@@ -1063,7 +1821,26 @@ private:
                               size_t size,
                               order_exec_cb_type exec_cb,
                               const AdvancedOrderTicket& aot,
-                              id_type id );
+                              id_type id,
+                              id_type client_id,
+                              owner_type owner,
+                              std::shared_ptr<order_batch_bndl>&& batch,
+                              std::unique_ptr<pull_filter>&& filter );
+
+        /* inline mode: the same, executed in the call */
+        id_type
+        _execute_inline( order_type oty,
+                         bool buy,
+                         double limit,
+                         double stop,
+                         size_t size,
+                         order_exec_cb_type exec_cb,
+                         const AdvancedOrderTicket& aot,
+                         id_type id,
+                         id_type client_id,
+                         owner_type owner,
+                         order_batch_bndl *batch,
+                         const pull_filter *filter );
 
         /*
          * push order onto the internal queue, DONT BLOCK - this can
@@ -1090,6 +1867,10 @@ private:
         std::pair<bool, size_t>
         _limit_is_fillable( plevel p, size_t sz, bool allow_partial );
 
+        /* change the size of a live order, in place if we can */
+        id_type
+        _modify_order(id_type id, size_t new_size);
+
         /* remove a particular order by id... */
         bool
         _pull_order(id_type id, bool pull_linked);
@@ -1112,12 +1893,50 @@ private:
         bool
         _in_cache(id_type id) const;
 
+        /* client id -> engine id of live order (0 if none) */
+        id_type
+        _resolve_client_id(id_type client_id) const;
+
+        /* engine id -> client id (0 if none) */
+        id_type
+        _client_id_of(id_type id) const;
+
+        void
+        _client_id_bind(id_type client_id, id_type id);
+
+        /* move the client id (if any) of one engine id to another */
+        void
+        _client_id_rebind(id_type id_old, id_type id_new);
+
+        void
+        _client_id_erase(id_type id);
+
+        /* erase the client id of an order that didn't make it into the book */
+        void
+        _client_id_prune(id_type id);
+
+        /* owner of a live order (0 if none) */
+        owner_type
+        _owner_of(id_type id);
+
+        void
+        _owner_bind(owner_type owner, id_type id);
+
+        void
+        _owner_erase(owner_type owner, id_type id);
+
+        size_t
+        _execute_owner_pull(owner_type owner, const pull_filter& filter);
+
         bool
         _is_buy_order(plevel p, const limit_bndl& o) const;
 
         bool
         _is_buy_order(plevel p, const stop_bndl& o) const;
 
+        bool
+        _is_buy_order(const chain_iter_wrap& iwrap) const;
+
         /* generate order ids; don't worry about overflow */
         inline id_type
         _generate_id()
@@ -1130,6 +1949,14 @@ private:
                                             size_t>::type >
         _limit_depth(size_t depth) const;
 
+        template<bool BuySide>
+        size_t
+        _limit_depth_levels(depth_level *levels, size_t n) const;
+
+        template<bool BuyMarket>
+        fill_estimate
+        _estimate_fill(size_t size) const;
+
         /* total size of bid or ask limits/stops/aons */
         template<side_of_trade Side, typename ChainTy>
         size_t
@@ -1143,6 +1970,30 @@ private:
         void
         _dump_aon_orders(std::ostream& out) const;
 
+        /* false if the visitor stopped; adds to 'n' the # visited */
+        template<bool BuySide>
+        bool
+        _visit_limit_levels( double min_price,
+                             double max_price,
+                             visitor_fn_type<level_view> visitor,
+                             void *arg,
+                             size_t& n ) const;
+
+        size_t
+        _visit_levels( side_of_market side,
+                       double min_price,
+                       double max_price,
+                       visitor_fn_type<level_view> visitor,
+                       void *arg ) const;
+
+        size_t
+        _visit_orders( side_of_trade side,
+                       double min_price,
+                       double max_price,
+                       order_type type,
+                       visitor_fn_type<order_view> visitor,
+                       void *arg ) const;
+
         /* called from grow book to reset invalidated pointers */
         void
         _reset_internal_pointers(plevel old_beg,
@@ -1222,7 +2073,9 @@ private:
                           size_t size,
                           order_exec_cb_type exec_cb = nullptr,
                           const AdvancedOrderTicket& advanced
-                              = AdvancedOrderTicket::null);
+                              = AdvancedOrderTicket::null,
+                          id_type client_id = 0,
+                          owner_type owner = 0);
 
         std::future<id_type>
         insert_limit_order_async(bool buy,
@@ -1230,21 +2083,27 @@ private:
                                  size_t size,
                                  order_exec_cb_type exec_cb = nullptr,
                                  const AdvancedOrderTicket& advanced
-                                     = AdvancedOrderTicket::null);
+                                     = AdvancedOrderTicket::null,
+                                 id_type client_id = 0,
+                                 owner_type owner = 0);
 
         id_type
         insert_market_order(bool buy,
                            size_t size,
                            order_exec_cb_type exec_cb = nullptr,
                            const AdvancedOrderTicket& advanced
-                               = AdvancedOrderTicket::null);
+                               = AdvancedOrderTicket::null,
+                           id_type client_id = 0,
+                           owner_type owner = 0);
 
         std::future<id_type>
         insert_market_order_async(bool buy,
                                   size_t size,
                                   order_exec_cb_type exec_cb = nullptr,
                                   const AdvancedOrderTicket& advanced
-                                      = AdvancedOrderTicket::null);
+                                      = AdvancedOrderTicket::null,
+                                  id_type client_id = 0,
+                                  owner_type owner = 0);
 
         id_type
         insert_stop_order(bool buy,
@@ -1253,7 +2112,9 @@ private:
                          size_t size,
                          order_exec_cb_type exec_cb = nullptr,
                          const AdvancedOrderTicket& advanced
-                             = AdvancedOrderTicket::null);
+                             = AdvancedOrderTicket::null,
+                         id_type client_id = 0,
+                         owner_type owner = 0);
 
         std::future<id_type>
         insert_stop_order_async(bool buy,
@@ -1262,7 +2123,9 @@ private:
                                 size_t size,
                                 order_exec_cb_type exec_cb = nullptr,
                                 const AdvancedOrderTicket& advanced
-                                    = AdvancedOrderTicket::null);
+                                    = AdvancedOrderTicket::null,
+                                id_type client_id = 0,
+                                owner_type owner = 0);
 
         id_type
         insert_stop_order(bool buy,
@@ -1270,8 +2133,11 @@ private:
                           size_t size,
                           order_exec_cb_type exec_cb = nullptr,
                           const AdvancedOrderTicket& advanced
-                              = AdvancedOrderTicket::null)
-        { return insert_stop_order(buy, stop, 0, size, exec_cb, advanced); }
+                              = AdvancedOrderTicket::null,
+                          id_type client_id = 0,
+                          owner_type owner = 0)
+        { return insert_stop_order(buy, stop, 0, size, exec_cb, advanced,
+                                   client_id, owner); }
 
 
         std::future<id_type>
@@ -1280,8 +2146,17 @@ private:
                                 size_t size,
                                 order_exec_cb_type exec_cb = nullptr,
                                 const AdvancedOrderTicket& advanced
-                                    = AdvancedOrderTicket::null)
-        { return insert_stop_order_async(buy, stop, 0, size, exec_cb, advanced); }
+                                    = AdvancedOrderTicket::null,
+                                id_type client_id = 0,
+                                owner_type owner = 0)
+        { return insert_stop_order_async(buy, stop, 0, size, exec_cb, advanced,
+                                         client_id, owner); }
+
+        id_type
+        modify_order(id_type id, size_t new_size);
+
+        std::future<id_type>
+        modify_order_async(id_type id, size_t new_size);
 
         bool
         pull_order(id_type id);
@@ -1289,6 +2164,13 @@ private:
         std::future<id_type> // 1 = true, 0 = false
         pull_order_async(id_type id);
 
+        size_t
+        pull_all(owner_type owner, const pull_filter& filter = pull_filter());
+
+        std::future<id_type> // # pulled
+        pull_all_async(owner_type owner,
+                       const pull_filter& filter = pull_filter());
+
         id_type
         replace_with_limit_order(id_type id,
                                 bool buy,
@@ -1364,15 +2246,110 @@ private:
         { return replace_with_stop_order_async(id, buy, stop, 0, size, exec_cb,
                                                advanced); }
 
+        std::vector<batch_result>
+        insert_orders(const OrderBatch& batch);
+
+        std::future<std::vector<batch_result>>
+        insert_orders_async(const OrderBatch& batch);
+
         void
         wait_for_async_callbacks();
 
         order_info
         get_order_info(id_type id) const;
 
+        size_t
+        get_order_status(const id_type *ids, size_t n, order_status *out) const;
+
         void
         dump_internal_pointers(std::ostream& out = std::cout) const;
 
+        void
+        set_wait_strategy(wait_strategy ws, sob_thread thrd = sob_thread::both);
+
+        wait_strategy
+        get_wait_strategy(sob_thread thrd = sob_thread::dispatcher) const;
+
+        bool
+        pin_thread(unsigned int cpu, sob_thread thrd = sob_thread::both);
+
+        bool
+        name_thread(std::string name, sob_thread thrd = sob_thread::both);
+
+        void
+        set_depth_snapshot_levels(size_t n);
+
+        size_t
+        get_depth_snapshot_levels() const;
+
+        void
+        subscribe_depth_deltas(DepthDeltaRing *ring);
+
+        bool
+        unsubscribe_depth_deltas(DepthDeltaRing *ring);
+
+        void
+        subscribe_order_events(OrderEventRing *ring);
+
+        bool
+        unsubscribe_order_events(OrderEventRing *ring);
+
+        queue_time_stats
+        get_cancel_queue_time_stats() const;
+
+        queue_time_stats
+        get_order_queue_time_stats() const;
+
+        void
+        reset_queue_time_stats();
+
+        void
+        set_queue_capacity(size_t n,
+                           overflow_policy policy = overflow_policy::block);
+
+        size_t
+        get_queue_capacity() const;
+
+        overflow_policy
+        get_overflow_policy() const;
+
+        size_t
+        get_queue_depth() const;
+
+        unsigned long long
+        get_queue_rejections() const;
+
+        void
+        set_replace_coalescing(bool on);
+
+        bool
+        get_replace_coalescing() const;
+
+        void
+        set_clock(clock_source_type clock);
+
+        void
+        set_time(clock_type::time_point tp);
+
+        void
+        set_timestamp_per_window(bool on);
+
+        bool
+        get_timestamp_per_window() const;
+
+        void
+        add_bar_interval(clock_type::duration interval, size_t history);
+
+        bool
+        remove_bar_interval(clock_type::duration interval);
+
+        bool
+        is_inline() const
+        { return _inline_exec; }
+
+        void
+        set_inline_callback_buffer(std::vector<callback_event> *buf);
+
         void
         dump_limits(std::ostream& out = std::cout) const
         { _dump_orders<side_of_trade::both, limit_chain_type>(out); }
@@ -1421,10 +2398,25 @@ private:
         market_depth(size_t depth=8) const
         { return _limit_depth<side_of_market::both>(depth); }
 
+        size_t
+        bid_depth_levels(depth_level *levels, size_t n) const
+        { return _limit_depth_levels<true>(levels, n); }
+
+        size_t
+        ask_depth_levels(depth_level *levels, size_t n) const
+        { return _limit_depth_levels<false>(levels, n); }
+
         std::map<double, std::pair<size_t,size_t>>
         aon_market_depth() const;
 
-        // TODO stop market depth
+        fill_estimate
+        estimate_fill(bool buy, size_t size) const
+        { return buy ? _estimate_fill<true>(size) : _estimate_fill<false>(size); }
+
+        /* {price: (buy stop size, sell stop size)} within 'depth' ticks of
+           the last trade (of the whole book before there's been one) */
+        std::map<double, std::pair<size_t,size_t>>
+        stop_depth(size_t depth=8) const;
 
         double
         bid_price() const;
@@ -1471,7 +2463,14 @@ private:
         total_aon_size() const
         { return _total_depth<side_of_trade::both, aon_chain_type>(); }
 
-        // TODO total stop sizes
+        size_t
+        total_buy_stop_size() const;
+
+        size_t
+        total_sell_stop_size() const;
+
+        size_t
+        total_stop_size() const;
 
         size_t
         last_size() const;
@@ -1482,9 +2481,18 @@ private:
         id_type
         last_id() const;
 
+        top_of_book
+        get_top_of_book() const;
+
+        depth_snapshot
+        get_depth_snapshot() const;
+
         const std::vector<timesale_entry_type>&
         time_and_sales() const;
 
+        size_t
+        bars(clock_type::duration interval, bar *out, size_t n) const;
+
     };
 
     /* (non-inline) definitions in tpp/orderbook/impl.tpp */
@@ -1627,6 +2635,46 @@ struct order_info {
     order_info(const order_info& oi);
 };
 
+/*
+ * compact, fixed-size version of order_info (see get_order_status); just
+ * the condition/trigger of an advanced order, not the whole ticket
+ */
+struct order_status {
+    id_type id; // engine ID (client IDs are resolved)
+    long long limit_tick; // price / tick_size; 0 = none
+    long long stop_tick;
+    size_t size; // remaining
+    order_type type; // null = not (or no longer) in the book
+    bool is_buy;
+    order_condition condition;
+    condition_trigger trigger;
+
+    order_status();
+};
+
+struct top_of_book {
+    double bid_price;
+    size_t bid_size;
+    double ask_price;
+    size_t ask_size;
+    double last_price;
+    size_t last_size;
+    unsigned long long volume;
+    id_type last_id;
+    unsigned long long window; // # of execution windows closed so far
+
+    top_of_book();
+};
+
+struct depth_snapshot {
+    using level_type = std::pair<double, size_t>; // price, size
+    std::vector<level_type> bids; // best(highest) first
+    std::vector<level_type> asks; // best(lowest) first
+    unsigned long long window; // top_of_book::window it was taken at
+
+    depth_snapshot();
+};
+
 namespace detail{
 
 struct sob_types {
@@ -1646,6 +2694,7 @@ struct sob_types {
     using dfrd_cb_elem = sob_class::dfrd_cb_elem;
     using order_exec_cb_bndl = sob_class::order_exec_cb_bndl;
     using callback_queue_type = sob_class::callback_queue_type;
+    using callback_buffer_type = sob_class::callback_buffer_type;
 };
 
 } /* detail */
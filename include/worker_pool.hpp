@@ -0,0 +1,111 @@
+/*
+Copyright (C) 2017 Jonathon Ogden < jeog.dev@gmail.com >
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see http://www.gnu.org/licenses.
+*/
+
+#ifndef JO_SOB_WORKER_POOL
+#define JO_SOB_WORKER_POOL
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+namespace sob {
+
+/*
+ *   WorkerPool :
+ *
+ *      A fixed set of threads that run WorkerPool::Task objects (M tasks on
+ *      N threads). Each worker has its own run queue; tasks submitted from
+ *      a worker go on that worker's queue, tasks submitted from outside are
+ *      spread round-robin, and a worker that runs dry steals from the back
+ *      of the others' queues before going to sleep.
+ *
+ *      The pool never runs a task on two workers at once as long as the
+ *      caller doesn't submit a task that's already queued/running; the
+ *      orderbooks guarantee this w/ their own 'scheduled' flag.
+ *
+ *   WorkerPool::Task :
+ *
+ *      .run : do a slice of work; return true to be put back on the (current
+ *             worker's) run queue, false if the task will resubmit itself
+ *             when it has more work. Once run returns false the pool doesn't
+ *             touch the task again, so it can be destroyed by another thread.
+ */
+class WorkerPool {
+public:
+    class Task {
+    public:
+        virtual
+        ~Task() {}
+
+        virtual bool
+        run() = 0;
+    };
+
+    explicit WorkerPool(unsigned int nthreads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool& pool) = delete;
+    WorkerPool(WorkerPool&& pool) = delete;
+    WorkerPool& operator=(const WorkerPool& pool) = delete;
+    WorkerPool& operator=(WorkerPool&& pool) = delete;
+
+    void
+    submit(Task *task);
+
+    inline unsigned int
+    size() const
+    { return static_cast<unsigned int>(_workers.size()); }
+
+    /* is the calling thread one of our workers */
+    bool
+    in_worker() const;
+
+private:
+    struct worker {
+        std::deque<Task*> tasks;
+        std::mutex mtx;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<worker>> _workers;
+    std::atomic<size_t> _queued; // across all run queues
+    std::atomic<size_t> _sleeping;
+    std::atomic<size_t> _next; // round-robin for outside submits
+    std::mutex _sleep_mtx;
+    std::condition_variable _sleep_cond;
+    std::atomic<bool> _run_flag;
+
+    void
+    _threaded_worker(size_t index);
+
+    Task*
+    _pop(size_t index);
+
+    Task*
+    _steal(size_t index);
+
+    void
+    _push(size_t index, Task *task);
+};
+
+}; /* sob */
+
+#endif /* JO_SOB_WORKER_POOL */
@@ -36,6 +36,7 @@ struct Strings{
     size[],
     callback[],
     depth[],
+    buffer[],
     sob_type[],
     low[],
     high[],
@@ -496,6 +496,44 @@ SOB_aon_market_depth(pySOB *self)
 }
 
 
+/* fill a caller's writable buffer (bytearray, array, numpy etc.) w/
+   sob::depth_level records; python side unpacks w/ struct format 'dNN' */
+template<bool BuySide>
+PyObject*
+SOB_depth_levels(pySOB *self, PyObject *args, PyObject *kwds)
+{
+    static char* kwlist[] = {Strings::buffer, NULL};
+
+    PyObject *obj = NULL;
+    if( !MethodArgs::parse(args, kwds, "O", kwlist, &obj) ){
+        return NULL;
+    }
+
+    Py_buffer view;
+    if( PyObject_GetBuffer(obj, &view, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS) ){
+        return NULL;
+    }
+
+    size_t n = 0;
+    Py_BEGIN_ALLOW_THREADS
+    try{
+        sob::FullInterface *ob = self->interface;
+        sob::depth_level *levels = static_cast<sob::depth_level*>(view.buf);
+        size_t max_n = static_cast<size_t>(view.len) / sizeof(sob::depth_level);
+        n = BuySide ? ob->bid_depth_levels(levels, max_n)
+                    : ob->ask_depth_levels(levels, max_n);
+    }catch(std::exception& e){
+        Py_BLOCK_THREADS
+        PyBuffer_Release(&view);
+        CONVERT_AND_THROW_NATIVE_EXCEPTION(e);
+        Py_UNBLOCK_THREADS
+    }
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&view);
+    return PyLong_FromSize_t(n);
+}
+
 template<bool Above>
 PyObject*
 SOB_grow_book(pySOB *self, PyObject *args, PyObject *kwds)
@@ -772,6 +810,19 @@ PyMethodDef pySOB_methods[] = {
     MDef::KeyArgs("market_depth",SOB_market_depth<sob::side_of_market::both>,
         DOCS_MARKET_DEPTH("market")),
 
+#define DOCS_DEPTH_LEVELS(arg1) \
+" write " arg1 " price levels, best first, into a buffer w/o allocating \n\n" \
+"    def " arg1 "_depth_levels(buffer) -> number of levels \n\n" \
+"    buffer :: writable buffer (e.g bytearray) :: as many levels as fit; \n" \
+"              each is struct format 'dNN' (price, size, # of orders) \n\n" \
+"    returns -> int \n"
+
+    MDef::KeyArgs("bid_depth_levels", SOB_depth_levels<true>,
+        DOCS_DEPTH_LEVELS("bid")),
+
+    MDef::KeyArgs("ask_depth_levels", SOB_depth_levels<false>,
+        DOCS_DEPTH_LEVELS("ask")),
+
     MDef::NoArgs("aon_market_depth", SOB_aon_market_depth,
                  "get total AON order size at each price level \n\n"
                  "    def aon_market_depth() -> {float:(long,long), ...} \n\n" ),
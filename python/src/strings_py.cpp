@@ -23,6 +23,7 @@ char Strings::limit[] = "limit";
 char Strings::size[] = "size";
 char Strings::callback[] = "callback";
 char Strings::depth[] = "depth";
+char Strings::buffer[] = "buffer";
 char Strings::sob_type[] = "sob_type";
 char Strings::low[] = "low";
 char Strings::high[] = "high";
@@ -0,0 +1,167 @@
+/*
+Copyright (C) 2017 Jonathon Ogden < jeog.dev@gmail.com >
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see http://www.gnu.org/licenses.
+*/
+
+#include <stdexcept>
+
+#include "../include/backtest_runner.hpp"
+
+namespace {
+
+using namespace sob;
+
+unsigned int
+default_nthreads(unsigned int nthreads)
+{
+    if( nthreads )
+        return nthreads;
+    unsigned int ncores = std::thread::hardware_concurrency();
+    return ncores ? ncores : 1;
+}
+
+} /* namespace */
+
+
+namespace sob{
+
+/* one job; runs start to finish the one time it's picked up by a worker */
+class BacktestRunner::job
+        : public WorkerPool::Task {
+    BacktestRunner *_runner;
+    size_t _index;
+
+public:
+    factory_type factory;
+    stream_type stream;
+
+    job(BacktestRunner *runner, size_t index, factory_type factory,
+        stream_type stream)
+        :
+            _runner(runner),
+            _index(index),
+            factory(factory),
+            stream(stream)
+        {
+        }
+
+    bool
+    run()
+    {
+        _runner->_run_job(_index);
+        return false; // DONT TOUCH 'this' - the runner may be done w/ us
+    }
+};
+
+
+BacktestRunner::BacktestRunner(unsigned int nthreads)
+    :
+        _pool( default_nthreads(nthreads) ),
+        _jobs(),
+        _results(nullptr),
+        _remaining(0),
+        _done_mtx(),
+        _done_cond(),
+        _books_mtx()
+    {
+    }
+
+
+BacktestRunner::~BacktestRunner()
+    {
+    }
+
+
+size_t
+BacktestRunner::add(factory_type factory, stream_type stream)
+{
+    if( !factory || !stream )
+        throw std::invalid_argument("backtest job needs a factory and a stream");
+    _jobs.emplace_back( new job(this, _jobs.size(), factory, stream) );
+    return _jobs.size() - 1;
+}
+
+
+std::vector<BacktestRunner::job_result>
+BacktestRunner::run()
+{
+    std::vector<job_result> results( _jobs.size() );
+    if( _jobs.empty() )
+        return results;
+
+    _results = &results;
+    _remaining = _jobs.size();
+    /* submitted round-robin; idle workers steal from the busy ones */
+    for( auto& j : _jobs )
+        _pool.submit( j.get() );
+
+    {
+        std::unique_lock<std::mutex> lock(_done_mtx);
+        _done_cond.wait( lock, [this]{ return _remaining == 0; } );
+    }
+    _results = nullptr;
+    _jobs.clear();
+    return results;
+}
+
+
+// called by a pool worker
+void
+BacktestRunner::_run_job(size_t index)
+{
+    job& j = *_jobs[index];
+    job_result& result = (*_results)[index];
+    FullInterface *ob = nullptr;
+
+    try{
+        {
+            std::lock_guard<std::mutex> lock(_books_mtx);
+            /* only books created by this thread, i.e this one */
+            SimpleOrderbook::UseInlineExecution(true, true);
+            try{
+                ob = j.factory();
+            }catch(...){
+                SimpleOrderbook::UseInlineExecution(false, true);
+                throw;
+            }
+            SimpleOrderbook::UseInlineExecution(false, true);
+        }
+        if( !ob )
+            throw std::runtime_error("backtest factory returned null");
+
+        auto start = clock_type::now();
+        j.stream(ob);
+        result.elapsed = clock_type::now() - start;
+
+        result.volume = ob->volume();
+        result.last_price = ob->last_price();
+        result.bid_price = ob->bid_price();
+        result.ask_price = ob->ask_price();
+        result.ntrades = ob->time_and_sales().size();
+    }catch(...){
+        result.error = std::current_exception();
+    }
+
+    if( ob ){
+        std::lock_guard<std::mutex> lock(_books_mtx);
+        SimpleOrderbook::Destroy(ob);
+    }
+
+    std::lock_guard<std::mutex> lock(_done_mtx);
+    if( --_remaining == 0 )
+        _done_cond.notify_one();
+}
+
+}; /* sob */
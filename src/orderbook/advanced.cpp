@@ -196,12 +196,12 @@ SOB_CLASS::_handle_bracket(_order_bndl& bndl, id_type id, size_t sz)
             auto& iwrap1 = _from_cache(bndl.price_bracket_orders->active1);
             auto& iwrap2 = _from_cache(bndl.price_bracket_orders->active2);
 
-            iwrap1.incr_size(sz);
+            _incr_size(iwrap1, sz);
             _push_exec_callback( callback_msg::trigger_BRACKET_adj_loss,
                                  iwrap1->cb, iwrap1->id, iwrap1->id,
                                  _itop(iwrap1.p), iwrap1->sz);
 
-            iwrap2.incr_size(sz);
+            _incr_size(iwrap2, sz);
             _push_exec_callback( callback_msg::trigger_BRACKET_adj_target,
                                  iwrap2->cb, iwrap2->id, iwrap2->id,
                                  _itop(iwrap2.p), iwrap2->sz);
@@ -252,7 +252,7 @@ SOB_CLASS::_handle_active_bracket(_order_bndl& bndl, id_type id, size_t sz)
 
     /* SHOULDN'T THROW */
     auto& iwrap = _from_cache(other_id);
-    iwrap.decr_size(sz);
+    _decr_size(iwrap, sz);
 
     auto msg = iwrap.is_limit()
             ? callback_msg::trigger_BRACKET_adj_target
@@ -279,7 +279,7 @@ SOB_CLASS::_handle_TRAILING_STOP(_order_bndl& bndl, id_type id, size_t sz)
          */
         try{
             auto& iwrap = _from_cache(bndl.contingent_nticks_order->active);
-            iwrap.incr_size(sz);
+            _incr_size(iwrap, sz);
             _push_exec_callback( callback_msg::trigger_TRAILING_STOP_adj_loss,
                                  iwrap->cb, iwrap->id, iwrap->id,
                                  _itop(iwrap.p), iwrap->sz );
@@ -810,7 +810,8 @@ SOB_CLASS::_trailing_stop_adjust(id_type id, bool buy_stop, plevel p)
     _push_exec_callback( msg, bndl.cb, id, id, price, bndl.sz );
 
     /* make 'new' stop active again */
-    chain<stop_chain_type>::push(this, p_adj, std::move(bndl));
+    chain<stop_chain_type>::push(this, p_adj, std::move(bndl),
+                                 order_event_type::modify);
 }
 
 
@@ -19,6 +19,18 @@ along with this program. If not, see http://www.gnu.org/licenses.
 #include <iomanip>
 #include <climits>
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#endif
+
 #include "../../include/simpleorderbook.hpp"
 #include "../../include/order_util.hpp"
 #include "specials.tpp"
@@ -33,6 +45,93 @@ along with this program. If not, see http://www.gnu.org/licenses.
 // TODO cache the aon levels in a list to avoid gaps in 'window' ??
 
 
+namespace {
+
+using namespace sob;
+
+/* how long spin_yield spins before it starts yielding the core */
+constexpr unsigned long SPINS_BEFORE_YIELD = 4096;
+
+inline void
+cpu_relax()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/*
+ * spin (w/o the queue lock) until there's work or we're switched back to
+ * blocking; the caller then waits on the condition variable as usual,
+ * which won't sleep if work is there
+ */
+template<typename F>
+void
+spin_for_work(F has_work, const std::atomic<wait_strategy>& ws)
+{
+    for( unsigned long n = 0; !has_work(); ++n ){
+        switch( ws.load(std::memory_order_relaxed) ){
+        case wait_strategy::blocking:
+            return;
+        case wait_strategy::spin_yield:
+            if( n >= SPINS_BEFORE_YIELD ){
+                std::this_thread::yield();
+                break;
+            }
+            /* no break */
+        case wait_strategy::busy_spin:
+            cpu_relax();
+        }
+    }
+}
+
+/* pulls by engine ID (pull_order w/o a size) go in the cancel lane */
+inline bool
+is_priority_cancel(order_type oty, id_type id, size_t size)
+{ return oty == order_type::null && id && !size && !is_client_id(id); }
+
+/* replaces and pulls (by either kind of ID) can supersede a queued replace */
+inline bool
+is_replace(order_type oty, id_type id)
+{ return oty != order_type::null && id; }
+
+inline bool
+is_replace_or_pull(order_type oty, id_type id, size_t size)
+{ return id && (oty != order_type::null || !size); }
+
+bool
+set_thread_affinity(std::thread::native_handle_type handle, unsigned int cpu)
+{
+#if defined(__linux__)
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    return pthread_setaffinity_np(handle, sizeof(cpus), &cpus) == 0;
+#elif defined(_WIN32)
+    return SetThreadAffinityMask(handle, DWORD_PTR(1) << cpu) != 0;
+#else
+    return false;
+#endif
+}
+
+bool
+set_thread_name(std::thread::native_handle_type handle, const std::string& name)
+{
+#if defined(__linux__)
+    /* linux limits names to 15 chars */
+    return pthread_setname_np(handle, name.substr(0,15).c_str()) == 0;
+#else
+    return false;
+#endif
+}
+
+} /* namespace */
+
+
 namespace sob{
 
 /***************************************************************
@@ -51,6 +150,8 @@ SOB_CLASS::SimpleOrderbookBase(
         std::function<long long(double, double)> ticks_in_range,
         std::function<bool(double)> is_valid_price )
     :
+        _inline_exec( SimpleOrderbook::InlineExecution() ),
+        _inline_callback_buffer(nullptr),
         /* actual orderbook object */
         _book(incr + 1), /*pad the beg side */
         _beg( &(*_book.begin()) + 1 ),
@@ -69,32 +170,96 @@ SOB_CLASS::SimpleOrderbookBase(
         _high_buy_aon( _beg - 1 ),
         _low_sell_aon( _end ),
         _high_sell_aon( _beg - 1 ),
+        _total_buy_stop_size(0),
+        _total_sell_stop_size(0),
         /* order/id caches for faster lookups */
         _id_cache(),
         _trailing_sell_stops(),
         _trailing_buy_stops(),
+        _client_ids(),
+        _client_ids_by_order(),
+        _owner_orders(),
         /* internal trade stats */
         _total_volume(0),
         _last_id(0),
         _last_size(0),
         _timesales(),
+        _bar_series(),
+        _clock(),
+        _timestamp_per_window(false),
+        _window_time_valid(false),
+        _window_time(),
+        _top_of_book(),
+        _depth_snapshots(),
+        _depth_snapshot_current(0),
+        _depth_snapshot_levels(0),
+        _depth_scratch_bids(),
+        _depth_scratch_asks(),
+        _depth_subscribers(),
+        _depth_dirty(),
+        _depth_delta_seq(0),
+        _order_event_subscribers(),
+        _order_event_parent(0),
+        _order_events_unpublished(false),
+        _beg_tick(0),
         /* sync callbacks */
         _callbacks_sync(),
+        _callbacks_sync_high_water(0),
+        _callback_buffers(),
+        _callback_buffers_mtx(),
         /* async callbacks */
+        _async_callback_ring(ASYNC_CALLBACK_RING_SIZE),
+        _async_callback_ring_write(0),
+        _async_callback_ring_published(0),
+        _async_callback_ring_read(0),
+        _async_callbacks_overflow(false),
         _callbacks_async(),
+        _async_callbacks_issued(0),
+        _async_callbacks_executed(0),
         _async_callback_mtx(),
         _async_callback_cond(),
         _async_callback_done_cond(),
-        _async_callbacks_done(true),
+        _async_callback_thread_waiting(false),
+        _async_callback_wait(wait_strategy::blocking),
+        _callback_pool( _inline_exec ? nullptr
+                                     : SimpleOrderbook::callback_pool_in_use() ),
+        _pooled_callback_executor(this, &SOB_CLASS::_pooled_async_callback_executor),
+        _async_callbacks_scheduled(false),
+        _async_callbacks_stopped(),
         /* our threaded approach to order queuing/exec */
         _external_order_queue(),
         _external_order_queue_mtx(),
         _external_order_queue_cond(),
+        _external_orders_pending(false),
+        _dispatcher_wait(wait_strategy::blocking),
+        _queue_capacity(0),
+        _overflow_policy(overflow_policy::block),
+        _queue_rejections(0),
+        _blocked_pushers(0),
+        _queue_space_cond(),
+        _cancel_order_queue(),
+        _cancels_in_a_row(0),
+        _coalesce_replaces(false),
+        _queued_replaces(),
+        _superseded_in_queue(0),
+        _cancel_queue_times(),
+        _order_queue_times(),
+        _dispatcher_config(),
+        _async_callback_config(),
+        _async_callback_thread_handle(),
+        _async_callback_thread_live(false),
+        _thread_config_mtx(),
         _internal_order_queue(),
         _need_check_for_stops(false),
         /* core sync objects */
         _master_mtx(),
         _master_run_flag(true),
+        _order_dispatcher_thread(),
+        _dispatcher_pool( _inline_exec ? nullptr
+                                       : SimpleOrderbook::dispatcher_pool_in_use() ),
+        _pooled_dispatcher(this, &SOB_CLASS::_pooled_order_dispatcher),
+        _dispatcher_scheduled(false),
+        _pooled_async_callback_thread(),
         /* price <-> tick conversion functions */
         _itop(itop),
         _ptoi(ptoi),
@@ -102,22 +267,37 @@ SOB_CLASS::SimpleOrderbookBase(
         _is_valid_price(is_valid_price)
     {
         /*** DONT THROW AFTER THIS POINT ***/
-        _order_dispatcher_thread =
-            std::thread(std::bind(&SOB_CLASS::_threaded_order_dispatcher,this));
+        if( _inline_exec )
+            return; // no threads
+        if( _dispatcher_pool ){
+            _pooled_async_callback_thread.reset(
+                new AsyncCallbackThreadGuard(this)
+            );
+        }else{
+            _order_dispatcher_thread =
+                std::thread(std::bind(&SOB_CLASS::_threaded_order_dispatcher,this));
+        }
     }
 
 
 SOB_CLASS::~SimpleOrderbookBase()
     {
         _master_run_flag = false;
+        if( _inline_exec )
+            return;
         try{
-            {
-                std::lock_guard<std::mutex> lock(_external_order_queue_mtx);
-                _external_order_queue.emplace();
-            }
-            _external_order_queue_cond.notify_one();
-            if( _order_dispatcher_thread.joinable() ){
-                _order_dispatcher_thread.join();
+            if( _dispatcher_pool ){
+                _stop_pooled_dispatcher();
+            }else{
+                {
+                    std::lock_guard<std::mutex> lock(_external_order_queue_mtx);
+                    _external_order_queue.emplace_back();
+                    _external_orders_pending = true;
+                }
+                _external_order_queue_cond.notify_one();
+                if( _order_dispatcher_thread.joinable() ){
+                    _order_dispatcher_thread.join();
+                }
             }
         }catch( std::exception& e ){
             std::cerr<< "exception in sob destructor: " << e.what() << std::endl;
@@ -132,15 +312,14 @@ SOB_CLASS::_threaded_order_dispatcher()
 
     for( ; ; ){
         external_order_queue_elem e;
+        spin_for_work([this]{ return _external_orders_pending.load(); },
+                      _dispatcher_wait);
         {
             std::unique_lock<std::mutex> lock(_external_order_queue_mtx);
             _external_order_queue_cond.wait(
                 lock,
-                [this]{ return !this->_external_order_queue.empty(); }
+                [&]{ return this->_pop_external_order(e); }
             );
-
-            e = std::move(_external_order_queue.front());
-            _external_order_queue.pop();
         }
 
         if( !_master_run_flag )
@@ -155,23 +334,284 @@ SOB_CLASS::_threaded_order_dispatcher()
 }
 
 
+// called by a pool worker; true = more to do, put us back on the run queue
+bool
+SOB_CLASS::_pooled_order_dispatcher()
+{
+    for( size_t n = 0; n < POOLED_DISPATCH_SLICE; ++n ){
+        external_order_queue_elem e;
+        {
+            std::lock_guard<std::mutex> lock(_external_order_queue_mtx);
+            if( !_pop_external_order(e) ){
+                /* any push after this (it needs the lock) reschedules us */
+                _dispatcher_scheduled = false;
+                return false;
+            }
+        }
+
+        if( !_master_run_flag ){
+            /*
+             * the derived part is gone so drop(break the promises of)
+             * everything up to the destructor's sentinel, like the
+             * dedicated dispatcher does; DONT TOUCH 'this' AFTER set_value
+             */
+            if( e.type == order_type::null && !e.id && !e.batch && !e.filter ){
+                std::promise<std::pair<id_type, callback_buffer_type>> done(
+                    std::move(e.promise_sync)
+                );
+                done.set_value( std::make_pair(0, callback_buffer_type()) );
+                return false;
+            }
+            continue;
+        }
+
+        e.cb.is_synchronous()
+            ? _dispatch_external_order(e, std::move(e.promise_sync) )
+            : _dispatch_external_order(e, std::move(e.promise_async) );
+    }
+    return true;
+}
+
+
+// _external_order_queue_mtx must be held
+bool
+SOB_CLASS::_pop_external_order(external_order_queue_elem& e)
+{
+    for( ; ; ){
+        bool cancels = !_cancel_order_queue.empty();
+        bool orders = !_external_order_queue.empty();
+
+        if( cancels && (!orders || _cancels_in_a_row < CANCEL_LANE_BURST) ){
+            e = std::move(_cancel_order_queue.front());
+            _cancel_order_queue.pop();
+            ++_cancels_in_a_row;
+            break;
+        }else if( orders ){
+            _forget_queued_replace(_external_order_queue.front());
+            e = std::move(_external_order_queue.front());
+            _external_order_queue.pop_front();
+            if( e.superseded ){ // already completed
+                --_superseded_in_queue;
+                continue;
+            }
+            _cancels_in_a_row = 0;
+            break;
+        }else{
+            _external_orders_pending = false;
+            return false;
+        }
+    }
+
+    if( _cancel_order_queue.empty() && _external_order_queue.empty() )
+        _external_orders_pending = false;
+    if( _blocked_pushers )
+        _queue_space_cond.notify_one();
+    return true;
+}
+
+
+// _external_order_queue_mtx must be held (via 'lock')
+void
+SOB_CLASS::_admit_external_order( std::unique_lock<std::mutex>& lock,
+                                  bool priority_cancel )
+{
+    if( _overflow_policy == overflow_policy::block ){
+        ++_blocked_pushers;
+        _queue_space_cond.wait(
+            lock,
+            [this]{ return _overflow_policy != overflow_policy::block
+                           || !_queue_capacity
+                           || _queue_depth() < _queue_capacity; }
+        );
+        --_blocked_pushers;
+        if( !_queue_capacity || _queue_depth() < _queue_capacity )
+            return;
+        /* still full but no longer blocking; admit under the new policy */
+    }
+
+    /* shed: a pull takes the place of the newest order still waiting */
+    while( _overflow_policy == overflow_policy::shed
+           && priority_cancel && !_external_order_queue.empty() )
+    {
+        external_order_queue_elem e;
+        _forget_queued_replace(_external_order_queue.back());
+        e = std::move(_external_order_queue.back());
+        _external_order_queue.pop_back();
+        if( e.superseded ){ // already completed, doesn't count
+            --_superseded_in_queue;
+            continue;
+        }
+        ++_queue_rejections;
+        _fail_external_order( e, std::make_exception_ptr(
+            queue_full_error("order shed from full queue")) );
+        return;
+    }
+
+    ++_queue_rejections;
+    throw queue_full_error("order queue full");
+}
+
+
+void
+SOB_CLASS::_fail_external_order( external_order_queue_elem& e,
+                                 std::exception_ptr error )
+{
+    if( e.cb.is_synchronous() )
+        e.promise_sync.set_exception(error);
+    else{
+        e.promise_async.set_exception(error);
+        if( e.batch )
+            e.batch->promise.set_exception(error);
+    }
+}
+
+
+// _external_order_queue_mtx must be held
+bool
+SOB_CLASS::_supersede_queued_replace(id_type id)
+{
+    auto r = _queued_replaces.find(id);
+    if( r == _queued_replaces.end() )
+        return false;
+
+    external_order_queue_elem& e = *r->second;
+    _queued_replaces.erase(r);
+    e.superseded = true;
+    ++_superseded_in_queue;
+    if( e.cb.is_synchronous() )
+        e.promise_sync.set_value( std::make_pair(superseded_id,
+                                                 callback_buffer_type()) );
+    else
+        e.promise_async.set_value(superseded_id);
+    return true;
+}
+
+
+// _external_order_queue_mtx must be held
+void
+SOB_CLASS::_forget_queued_replace(const external_order_queue_elem& e)
+{
+    if( _queued_replaces.empty() || e.superseded || !is_replace(e.type, e.id) )
+        return;
+
+    auto r = _queued_replaces.find(e.id);
+    if( r != _queued_replaces.end() && r->second == &e )
+        _queued_replaces.erase(r);
+}
+
+
+// _master_mtx must be held
+void
+SOB_CLASS::_record_queue_time( const external_order& e,
+                               clock_type::time_point queued_at )
+{
+    if( queued_at == clock_type::time_point() )
+        return; // never queued (inline)
+
+    queue_time_stats& stats = is_priority_cancel(e.type, e.id, e.sz)
+                            ? _cancel_queue_times
+                            : _order_queue_times;
+
+    clock_type::duration d = clock_type::now() - queued_at;
+    ++stats.count;
+    stats.total += d;
+    if( d > stats.max )
+        stats.max = d;
+}
+
+
+void
+SOB_CLASS::_schedule_pooled_dispatcher()
+{
+    if( !_dispatcher_scheduled.exchange(true) )
+        _dispatcher_pool->submit(&_pooled_dispatcher);
+}
+
+
+/*
+ * queue a sentinel behind everything else and wait for a worker to get
+ * to it; after that the pool is done with us
+ */
+void
+SOB_CLASS::_stop_pooled_dispatcher()
+{
+    using T = std::pair<id_type, callback_buffer_type>;
+
+    std::promise<T> p;
+    std::future<T> f(p.get_future());
+    {
+        std::lock_guard<std::mutex> lock(_external_order_queue_mtx);
+        _external_order_queue.emplace_back(
+            order_type::null, false, 0, 0, 0,
+            order_exec_cb_bndl{nullptr, order_exec_cb_bndl::type::synchronous, 0},
+            0, AdvancedOrderTicket::null, 0, std::move(p) );
+        _external_orders_pending = true;
+    }
+    _schedule_pooled_dispatcher();
+    f.wait();
+
+    // end/join async callback thread (via ~AsyncCallbackThread)
+    _pooled_async_callback_thread.reset();
+}
+
+
 template<typename T>
 void
 SOB_CLASS::_dispatch_external_order( const external_order_queue_elem& ee,
                                      std::promise<T>&& promise )
 {
     id_type ret;
-    callback_queue_type copies;
+    callback_buffer_type copies;
+
+    try{
+        ret = _execute_window( ee, ee.batch.get(), ee.filter.get(), ee.queued_at,
+                               detail::promise_helper<T>::is_synchronous
+                                   ? &copies : nullptr );
+    }catch(...){
+         promise.set_exception( std::current_exception() );
+         if( ee.batch && !detail::promise_helper<T>::is_synchronous )
+             ee.batch->promise.set_exception( std::current_exception() );
+         return;
+     }
+
+     promise.set_value( detail::promise_helper<T>::build_value(ret, copies) );
+     /* insert_orders(sync) reads the results when the promise above is set */
+     if( ee.batch && !detail::promise_helper<T>::is_synchronous )
+         ee.batch->promise.set_value( std::move(ee.batch->results) );
+}
+
+id_type
+SOB_CLASS::_execute_window( const external_order& e,
+                            order_batch_bndl *batch,
+                            const pull_filter *filter,
+                            clock_type::time_point queued_at,
+                            callback_buffer_type *sync_callbacks )
+{
+    id_type ret;
 
     try{
          /* --- CRITICAL SECTION --- */
          std::lock_guard<std::mutex> lock(_master_mtx);
 
-         ret = _execute_external_order( ee );
-
-         if( detail::promise_helper<T>::is_synchronous ){
-             copies = _callbacks_sync;
-             _callbacks_sync.clear();
+         _window_time_valid = false;
+         _record_queue_time( e, queued_at );
+         if( batch )
+             ret = _execute_order_batch( *batch );
+         else if( filter )
+             ret = _execute_owner_pull( e.cb.owner, *filter );
+         else
+             ret = _execute_external_order( e );
+         _publish_top_of_book();
+         _publish_depth_snapshot();
+         _publish_depth_deltas();
+         _publish_order_events();
+         _publish_async_callbacks();
+
+         if( sync_callbacks && !_callbacks_sync.empty() ){
+             _callbacks_sync_high_water = std::max(_callbacks_sync_high_water,
+                                                   _callbacks_sync.size());
+             sync_callbacks->swap(_callbacks_sync);
+             _callbacks_sync = _take_callback_buffer();
          }
 
          _assert_internal_pointers();
@@ -179,37 +619,86 @@ SOB_CLASS::_dispatch_external_order( const external_order_queue_elem& ee,
      }catch(...){
          while( !_internal_order_queue.empty() )
               _internal_order_queue.pop();
-
-         promise.set_exception( std::current_exception() );
-         return;
+         _publish_top_of_book();
+         _publish_depth_snapshot();
+         _publish_depth_deltas();
+         _publish_order_events();
+         _publish_async_callbacks();
+         throw;
      }
 
-     promise.set_value( detail::promise_helper<T>::build_value(ret, copies) );
+     return ret;
+}
+
+
+// called by the caller's thread after the window closes
+void
+SOB_CLASS::_deliver_sync_callbacks(callback_buffer_type&& callbacks)
+{
+    if( _inline_callback_buffer ){
+        if( _inline_callback_buffer->empty() )
+            _inline_callback_buffer->swap(callbacks);
+        else{
+            for( auto& e : callbacks )
+                _inline_callback_buffer->push_back( std::move(e) );
+        }
+    }else{
+        for( const auto & e : callbacks ){ // no need to protect, ours now
+            assert( e.exec_cb );
+            e();
+        }
+    }
+
+    if( callbacks.capacity() )
+        _recycle_callback_buffer( std::move(callbacks) );
 }
 
+
 id_type
-SOB_CLASS::_execute_external_order(const external_order_queue_elem& ee)
+SOB_CLASS::_execute_external_order(const external_order& ee)
 {
     id_type ret = 1;
+    id_type id = ee.id;
+
+    /* client ids resolve to whatever order currently holds them */
+    if( id && is_client_id(id) ){
+        id = _resolve_client_id(id);
+        if( !id )
+            return 0;
+    }
 
-    if( ee.id ){
+    if( id ){
         if( ee.type != order_type::null ) { // REPLACE
             order_queue_elem qe(ee, this);
+            id_type client_id = _client_id_of(id);
+            qe.cb.owner = _owner_of(id);
 
-            if( !_pull_order(ee.id, true) )
+            if( !_pull_order(id, true) )
                 return 0;
 
-           qe.id = _generate_id();
-            _insert_order(qe);
+            qe.id = _generate_id();
+            if( client_id )
+                _client_id_bind(client_id, qe.id);
+            _insert_order(qe, id);
+            _client_id_prune(qe.id);
             ret = qe.id; // return new order ID
+        }else if( ee.sz ){ // MODIFY (size only)
+            ret = _modify_order(id, ee.sz);
+            if( !ret )
+                return 0;
         }else{ // PULL
-            if( !_pull_order(ee.id, true) )
+            if( !_pull_order(id, true) )
                 return 0;
         }
     }else{ // INSERT ONLY
         order_queue_elem qe(ee, this);
+        if( ee.client_id && _resolve_client_id(ee.client_id) )
+            throw std::invalid_argument("client id already in use");
         qe.id = _generate_id();
+        if( ee.client_id )
+            _client_id_bind(ee.client_id, qe.id);
         _insert_order(qe);
+        _client_id_prune(qe.id);
         ret = qe.id; // return new order ID
     }
 
@@ -219,6 +708,7 @@ SOB_CLASS::_execute_external_order(const external_order_queue_elem& ee)
         if( !ie.id )
            ie.id = _generate_id();
         _insert_order(ie);
+        _client_id_prune(ie.id);
         _internal_order_queue.pop();
     }
 
@@ -227,12 +717,14 @@ SOB_CLASS::_execute_external_order(const external_order_queue_elem& ee)
 
 
 void
-SOB_CLASS::_insert_order(order_queue_elem& e)
+SOB_CLASS::_insert_order(order_queue_elem& e, id_type event_parent)
 {
+    _order_event_parent = event_parent ? event_parent : e.parent_id;
     if( detail::order::is_advanced(e) )
         _route_advanced_order(e);
     else
         _route_basic_order<>(e);
+    _order_event_parent = 0;
 }
 
 
@@ -324,7 +816,8 @@ SOB_CLASS::_trade( plevel plev,
             /* first, match against the AON chain */
             aon_chain_type *ac = p->aon_chain<BidSide>().get();
             if( ac ){
-                std::tie(size, all) = _hit_aon_chain(ac, p, id, size, cb);
+                std::tie(size, all) = _hit_aon_chain(ac, p, id, size, cb,
+                                                      !BidSide);
                 if( all ){
                     p->aon_chain<BidSide>().free();
                     AON::adjust_state_after_pull(this, p);
@@ -336,7 +829,8 @@ SOB_CLASS::_trade( plevel plev,
             /* then, match against the limit chain (which CAN have AON orders) */
             limit_chain_type *lc = p->limits.get();
             if( lc ){
-                std::tie(size, all) = _hit_chain( lc, p, id, size, cb );
+                std::tie(size, all) = _hit_chain( lc, p, id, size, cb,
+                                                  !BidSide );
                 if( all ){
                     p->limits.free();
                     CORE::find_new_best_inside(this);
@@ -389,7 +883,8 @@ SOB_CLASS::_hit_chain( limit_chain_type *lchain,
                        plevel plev,
                        id_type id,
                        size_t size,
-                       const order_exec_cb_bndl& cb )
+                       const order_exec_cb_bndl& cb,
+                       bool buy )
 {
     using namespace detail;
 
@@ -397,6 +892,7 @@ SOB_CLASS::_hit_chain( limit_chain_type *lchain,
 
     auto pos = lchain->begin();
     assert( order::is_limit(*pos) );
+    _depth_touch(plev);
 
     for( ; pos != lchain->end() && size > 0; ++pos )
     {
@@ -412,7 +908,7 @@ SOB_CLASS::_hit_chain( limit_chain_type *lchain,
         size_t amount = std::min(size, pos->sz);
 
         /* push callbacks onto queue; update state */
-        _trade_has_occured( plev, amount, id, pos->id, cb, pos->cb );
+        _trade_has_occured( plev, amount, id, pos->id, cb, pos->cb, buy );
 
         /* reduce the amount left to trade */
         size -= amount;     
@@ -433,8 +929,11 @@ SOB_CLASS::_hit_chain( limit_chain_type *lchain,
         pos->sz -= amount;
 
         /* remove from cache if none left */
-        if( pos->sz == 0 )
+        if( pos->sz == 0 ){
             _id_cache.erase(pos->id);
+            _client_id_erase(pos->id);
+            _owner_erase(pos->cb.owner, pos->id);
+        }
     }
 
     /* backup to see if last order was completely filled, if so re-incr */
@@ -454,7 +953,8 @@ SOB_CLASS::_hit_aon_chain( aon_chain_type *achain,
                            plevel plev,
                            id_type id,
                            size_t size,
-                           const order_exec_cb_bndl& cb_bndl )
+                           const order_exec_cb_bndl& cb_bndl,
+                           bool buy )
 {
     assert( achain && !achain->empty() );
 
@@ -462,9 +962,12 @@ SOB_CLASS::_hit_aon_chain( aon_chain_type *achain,
     {
         if( size >= pos->sz ){
             // TODO buy/sell order
-            _trade_has_occured(plev, pos->sz, id, pos->id, cb_bndl, pos->cb);
+            _trade_has_occured(plev, pos->sz, id, pos->id, cb_bndl, pos->cb,
+                               buy);
             size -= pos->sz;
             _id_cache.erase(pos->id);
+            _client_id_erase(pos->id);
+            _owner_erase(pos->cb.owner, pos->id);
             pos = achain->erase(pos);
         }else
             ++pos;
@@ -473,24 +976,32 @@ SOB_CLASS::_hit_aon_chain( aon_chain_type *achain,
 }
 
 
-/* two orders have been matched */
+/* two orders have been matched ('buy1' - the first is the buy side) */
 void
 SOB_CLASS::_trade_has_occured( plevel plev,
                                size_t size,
-                               id_type idbuy,
-                               id_type idsell,
-                               const order_exec_cb_bndl& cbbuy,
-                               const order_exec_cb_bndl& cbsell )
+                               id_type id1,
+                               id_type id2,
+                               const order_exec_cb_bndl& cb1,
+                               const order_exec_cb_bndl& cb2,
+                               bool buy1 )
 {
     /* CAREFUL: we can't insert orders from here since we have yet to finish
        processing the initial order (possible infinite loop); */
     double p = _itop(plev);
 
     /* buy and sell sides */
-    _push_exec_callback(callback_msg::fill, cbbuy, idbuy, idbuy, p, size);
-    _push_exec_callback(callback_msg::fill, cbsell, idsell, idsell, p, size);
-
-    _timesales.push_back( std::make_tuple(clock_type::now(), p, size) );
+    _push_exec_callback(callback_msg::fill, cb1, id1, id1, p, size);
+    _push_exec_callback(callback_msg::fill, cb2, id2, id2, p, size);
+    _order_event(order_event_type::fill, id1, buy1, plev, size,
+                 order_type::null, id2);
+    _order_event(order_event_type::fill, id2, !buy1, plev, size,
+                 order_type::null, id1);
+
+    clock_type::time_point tp = _trade_time();
+    _timesales.push_back( std::make_tuple(tp, p, size) );
+    if( !_bar_series.empty() )
+        _update_bars(tp, p, size);
     _last = plev;
     _total_volume += size;
     _last_size = size;
@@ -498,6 +1009,48 @@ SOB_CLASS::_trade_has_occured( plevel plev,
 }
 
 
+clock_type::time_point
+SOB_CLASS::_trade_time()
+{
+    if( !_timestamp_per_window )
+        return _clock ? _clock() : clock_type::now();
+
+    if( !_window_time_valid ){
+        _window_time = _clock ? _clock() : clock_type::now();
+        _window_time_valid = true;
+    }
+    return _window_time;
+}
+
+
+/* O(1) per interval; a trade stamped before the newest bar goes in it */
+void
+SOB_CLASS::_update_bars(clock_type::time_point tp, double price, size_t size)
+{
+    for( bar_series& s : _bar_series ){
+        clock_type::time_point start = tp - (tp.time_since_epoch() % s.interval);
+        size_t cap = s.bars.size();
+        bar *b = s.count ? &s.bars[(s.next + cap - 1) % cap] : nullptr;
+        if( !b || start > b->start ){
+            b = &s.bars[s.next];
+            s.next = (s.next + 1) % cap;
+            s.count = std::min(s.count + 1, cap);
+            s.notional = 0;
+            *b = bar();
+            b->start = start;
+            b->open = b->high = b->low = price;
+        }
+        b->high = std::max(b->high, price);
+        b->low = std::min(b->low, price);
+        b->close = price;
+        b->volume += size;
+        ++(b->ntrades);
+        s.notional += price * size;
+        b->vwap = s.notional / b->volume;
+    }
+}
+
+
 /*
  * CHECK IF ANY OLD AONs can be filled against new limit BEFORE we
  * send it to be matched against the book
@@ -543,7 +1096,7 @@ SOB_CLASS::_match_aon_orders_PRE_trade(const order_queue_elem& e, plevel p)
                  * we'll want a more robust price-mediation mechanism
                  */
                 _trade_has_occured( p , filled_this, bndl.id, e.id,
-                                    bndl.cb, e.cb );
+                                    bndl.cb, e.cb, !IsBuy );
 
                 // our limit still has this much left
                 rmndr -= filled_this;
@@ -722,15 +1275,98 @@ SOB_CLASS::_push_exec_callback(callback_msg msg,
 
 
 // called by dispatcher thread
+SOB_CLASS::callback_buffer_type
+SOB_CLASS::_take_callback_buffer()
+{
+    callback_buffer_type buf;
+    {
+        std::lock_guard<std::mutex> lock(_callback_buffers_mtx);
+        if( !_callback_buffers.empty() ){
+            buf.swap( _callback_buffers.back() );
+            _callback_buffers.pop_back();
+        }
+    }
+    buf.reserve(_callbacks_sync_high_water);
+    return buf;
+}
+
+
+// called by the caller's thread once its sync callbacks have run
+void
+SOB_CLASS::_recycle_callback_buffer(callback_buffer_type&& buf)
+{
+    buf.clear();
+    std::lock_guard<std::mutex> lock(_callback_buffers_mtx);
+    if( _callback_buffers.size() < MAX_RECYCLED_CALLBACK_BUFFERS )
+        _callback_buffers.push_back( std::move(buf) );
+}
+
+
+// called by dispatcher thread; not visible until _publish_async_callbacks
 template<typename... Args>
 void
 SOB_CLASS::_push_async_callback(Args&&... args)
 {
+    size_t w = _async_callback_ring_write;
+    if( !_async_callbacks_overflow.load(std::memory_order_relaxed)
+        && (w - _async_callback_ring_read.load(std::memory_order_acquire))
+            < ASYNC_CALLBACK_RING_SIZE )
+    {
+        _async_callback_ring[w & (ASYNC_CALLBACK_RING_SIZE - 1)] =
+            dfrd_cb_elem( std::forward<Args>(args)... );
+        _async_callback_ring_write = w + 1;
+        return;
+    }
+
+    /*
+     * ring is full: publish what's there (it all comes first) and
+     * spill into the overflow queue until the callback thread drains it
+     */
+    _publish_async_callbacks();
     {
         std::lock_guard<std::mutex> lock(_async_callback_mtx);
         _callbacks_async.emplace_back( std::forward<Args>(args)... );
+        ++_async_callbacks_issued;
+        _async_callbacks_overflow = true;
     }
-    _async_callback_cond.notify_one();
+    if( _callback_pool )
+        _schedule_pooled_callbacks();
+    else
+        _async_callback_cond.notify_one();
+}
+
+
+// called by dispatcher thread when a window closes
+void
+SOB_CLASS::_publish_async_callbacks()
+{
+    size_t w = _async_callback_ring_write;
+    size_t p = _async_callback_ring_published.load(std::memory_order_relaxed);
+    if( w == p )
+        return;
+
+    _async_callbacks_issued += (w - p);
+    _async_callback_ring_published.store(w);
+
+    if( _callback_pool ){
+        _schedule_pooled_callbacks();
+        return;
+    }
+
+    /* only pay for the wake-up if the callback thread is (about to be) asleep */
+    if( _async_callback_thread_waiting ){
+        { std::lock_guard<std::mutex> lock(_async_callback_mtx); }
+        _async_callback_cond.notify_one();
+    }
+}
+
+
+bool
+SOB_CLASS::_async_callbacks_ready() const
+{
+    return _async_callback_ring_published.load()
+            != _async_callback_ring_read.load(std::memory_order_relaxed)
+        || _async_callbacks_overflow.load();
 }
 
 
@@ -738,18 +1374,38 @@ SOB_CLASS::_push_async_callback(Args&&... args)
 SOB_CLASS::AsyncCallbackThreadGuard::AsyncCallbackThreadGuard(SOB_CLASS *sob)
     :
         _sob(sob),
-        _t( [=](){ sob->_threaded_async_callback_executor(); } )
+        _t()
     {
+        if( sob->_callback_pool )
+            return; // callbacks are run on the pool as they're published
+
+        _t = std::thread( [=](){ sob->_threaded_async_callback_executor(); } );
+        std::lock_guard<std::mutex> lock(sob->_thread_config_mtx);
+        sob->_async_callback_thread_handle = _t.native_handle();
+        sob->_async_callback_thread_live = true;
+        sob->_apply_thread_config(sob_thread::async_callback, _t.native_handle());
     }
 
 // called by dispatcher thread
 SOB_CLASS::AsyncCallbackThreadGuard::~AsyncCallbackThreadGuard()
     {
-        // send NULL signal to async callback thread and wait
+        {
+            std::lock_guard<std::mutex> lock(_sob->_thread_config_mtx);
+            _sob->_async_callback_thread_live = false;
+        }
+
+        std::future<void> stopped;
+        if( _sob->_callback_pool )
+            stopped = _sob->_async_callbacks_stopped.get_future();
+
+        // send NULL signal to async callback thread(pool) and wait
         _sob->_push_async_callback();
+        _sob->_publish_async_callbacks();
 
         if( _t.joinable() )
             _t.join();
+        else if( stopped.valid() )
+            stopped.wait();
     }
 
 
@@ -757,55 +1413,361 @@ void
 SOB_CLASS::_threaded_async_callback_executor()
 {
     for( ; ; ){
-        callback_queue_type copies;
+        callback_queue_type overflow;
+        size_t end;
+
+        spin_for_work([this]{ return _async_callbacks_ready(); },
+                      _async_callback_wait);
         {
             std::unique_lock<std::mutex> lock(_async_callback_mtx);
+            _async_callback_thread_waiting = true;
             _async_callback_cond.wait(
                 lock,
-                [this]{ return !_callbacks_async.empty(); }
+                [this]{ return _async_callbacks_ready(); }
             );
-            _async_callbacks_done = false;
-            copies = std::move(_callbacks_async);
-            _callbacks_async.clear();
+            _async_callback_thread_waiting = false;
+            _take_async_callbacks(end, overflow);
         }
 
-        for(auto b = copies.begin(); b < copies.end(); ++ b){
-            if( !b->exec_cb ){
-                auto d = std::distance(b, copies.end());
-                if( d > 1 )
-                    std::cerr << "leaving AsyncCallbackThread with " << d - 1
-                              << " outstanding callbacks" << std::endl;
-                _notify_async_callbacks_done();
-                return;
-            }
-            b->exec_cb( b->msg, b->id1, b->id2, b->price, b->sz );
-        }
-        _notify_async_callbacks_done();
+        if( !_run_async_callbacks(end, overflow) )
+            return;
     }
 }
 
-void
-SOB_CLASS::_notify_async_callbacks_done()
+
+// called by a pool worker; true = more to do, put us back on the run queue
+bool
+SOB_CLASS::_pooled_async_callback_executor()
 {
+    callback_queue_type overflow;
+    size_t end;
     {
         std::lock_guard<std::mutex> lock(_async_callback_mtx);
-        _async_callbacks_done = true;
+        _take_async_callbacks(end, overflow);
+    }
+
+    if( !_run_async_callbacks(end, overflow) ){
+        /* ~AsyncCallbackThreadGuard's NULL signal; DONT TOUCH 'this' AFTER set_value */
+        std::promise<void> stopped( std::move(_async_callbacks_stopped) );
+        stopped.set_value();
+        return false;
     }
-    _async_callback_done_cond.notify_one();
+
+    /* anything published after this (re)schedules us */
+    _async_callbacks_scheduled = false;
+    return _async_callbacks_ready() && !_async_callbacks_scheduled.exchange(true);
+}
+
+
+void
+SOB_CLASS::_schedule_pooled_callbacks()
+{
+    if( !_async_callbacks_scheduled.exchange(true) )
+        _callback_pool->submit(&_pooled_callback_executor);
+}
+
+
+/*
+ * the dispatcher doesn't touch the ring while the overflow queue
+ * is in use so everything published so far comes before it
+ */
+void
+SOB_CLASS::_take_async_callbacks(size_t& end, callback_queue_type& overflow)
+{
+    end = _async_callback_ring_published.load();
+    if( _async_callbacks_overflow ){
+        overflow = std::move(_callbacks_async);
+        _callbacks_async.clear();
+        _async_callbacks_overflow = false;
+    }
+}
+
+
+// false if we ran into the NULL(stop) callback
+bool
+SOB_CLASS::_run_async_callbacks(size_t end, callback_queue_type& overflow)
+{
+    size_t r = _async_callback_ring_read.load(std::memory_order_relaxed);
+    unsigned long long n = 0;
+    size_t outstanding = 0;
+    bool stop = false;
+    auto exec = [&](dfrd_cb_elem& e){
+        if( stop ){
+            ++outstanding;
+            return;
+        }
+        ++n;
+        if( !e.exec_cb ){
+            stop = true;
+            return;
+        }
+        e.exec_cb( e.msg, e.id1, e.id2, e.price, e.sz );
+    };
+
+    for( ; r != end; ){
+        dfrd_cb_elem& e = _async_callback_ring[r & (ASYNC_CALLBACK_RING_SIZE - 1)];
+        exec(e);
+        e.exec_cb = nullptr; // release callback state on this thread
+        _async_callback_ring_read.store(++r, std::memory_order_release);
+    }
+    for( auto& e : overflow ){
+        exec(e);
+    }
+
+    _async_callbacks_executed += n;
+    _notify_async_callbacks_done();
+    if( stop && outstanding ){
+        std::cerr << "leaving AsyncCallbackThread with " << outstanding
+                  << " outstanding callbacks" << std::endl;
+    }
+    return !stop;
+}
+
+void
+SOB_CLASS::_notify_async_callbacks_done()
+{
+    { std::lock_guard<std::mutex> lock(_async_callback_mtx); }
+    _async_callback_done_cond.notify_all();
 }
 
 void
 SOB_CLASS::wait_for_async_callbacks()
 {
     std::unique_lock<std::mutex> lock(_async_callback_mtx);
-    if( !_async_callbacks_done || !_callbacks_async.empty() ){
-        _async_callback_done_cond.wait(
-            lock,
-            [this]{ return _async_callbacks_done && _callbacks_async.empty(); }
-        );
+    _async_callback_done_cond.wait(
+        lock,
+        [this]{ return _async_callbacks_executed == _async_callbacks_issued; }
+    );
+}
+
+
+void
+SOB_CLASS::set_wait_strategy(wait_strategy ws, sob_thread thrd)
+{
+    if( thrd != sob_thread::async_callback )
+        _dispatcher_wait = ws;
+    if( thrd != sob_thread::dispatcher )
+        _async_callback_wait = ws;
+}
+
+
+wait_strategy
+SOB_CLASS::get_wait_strategy(sob_thread thrd) const
+{
+    switch(thrd){
+    case sob_thread::dispatcher: return _dispatcher_wait;
+    case sob_thread::async_callback: return _async_callback_wait;
+    default:
+        throw std::invalid_argument("get_wait_strategy needs a single thread");
+    }
+}
+
+
+void
+SOB_CLASS::set_queue_capacity(size_t n, overflow_policy policy)
+{
+    {
+        std::lock_guard<std::mutex> lock(_external_order_queue_mtx);
+        _queue_capacity = n;
+        _overflow_policy = policy;
+    }
+    /* more room (or no more blocking) for anyone already waiting */
+    _queue_space_cond.notify_all();
+}
+
+
+size_t
+SOB_CLASS::get_queue_capacity() const
+{
+    std::lock_guard<std::mutex> lock(_external_order_queue_mtx);
+    return _queue_capacity;
+}
+
+
+overflow_policy
+SOB_CLASS::get_overflow_policy() const
+{
+    std::lock_guard<std::mutex> lock(_external_order_queue_mtx);
+    return _overflow_policy;
+}
+
+
+size_t
+SOB_CLASS::get_queue_depth() const
+{
+    std::lock_guard<std::mutex> lock(_external_order_queue_mtx);
+    return _queue_depth();
+}
+
+
+unsigned long long
+SOB_CLASS::get_queue_rejections() const
+{
+    std::lock_guard<std::mutex> lock(_external_order_queue_mtx);
+    return _queue_rejections;
+}
+
+
+void
+SOB_CLASS::set_replace_coalescing(bool on)
+{
+    std::lock_guard<std::mutex> lock(_external_order_queue_mtx);
+    _coalesce_replaces = on;
+    if( !on )
+        _queued_replaces.clear();
+}
+
+
+bool
+SOB_CLASS::get_replace_coalescing() const
+{
+    std::lock_guard<std::mutex> lock(_external_order_queue_mtx);
+    return _coalesce_replaces;
+}
+
+
+void
+SOB_CLASS::set_clock(clock_source_type clock)
+{
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    _clock = clock;
+}
+
+
+void
+SOB_CLASS::set_time(clock_type::time_point tp)
+{
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    _clock = [=](){ return tp; };
+}
+
+
+void
+SOB_CLASS::set_timestamp_per_window(bool on)
+{
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    _timestamp_per_window = on;
+}
+
+
+bool
+SOB_CLASS::get_timestamp_per_window() const
+{
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    return _timestamp_per_window;
+}
+
+
+void
+SOB_CLASS::add_bar_interval(clock_type::duration interval, size_t history)
+{
+    if( interval <= clock_type::duration::zero() )
+        throw std::invalid_argument("bar interval <= 0");
+    if( history == 0 )
+        throw std::invalid_argument("bar history == 0");
+
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    /* --- CRITICAL SECTION --- */
+    for( bar_series& s : _bar_series ){
+        if( s.interval == interval ){
+            s = bar_series(interval, history);
+            return;
+        }
+    }
+    _bar_series.emplace_back(interval, history);
+    /* --- CRITICAL SECTION --- */
+}
+
+
+bool
+SOB_CLASS::remove_bar_interval(clock_type::duration interval)
+{
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    /* --- CRITICAL SECTION --- */
+    for( auto iter = _bar_series.begin(); iter != _bar_series.end(); ++iter ){
+        if( iter->interval == interval ){
+            _bar_series.erase(iter);
+            return true;
+        }
+    }
+    return false;
+    /* --- CRITICAL SECTION --- */
+}
+
+
+void
+SOB_CLASS::set_inline_callback_buffer(std::vector<callback_event> *buf)
+{
+    if( !_inline_exec )
+        throw std::logic_error("not an inline orderbook");
+    _inline_callback_buffer = buf;
+}
+
+
+bool
+SOB_CLASS::pin_thread(unsigned int cpu, sob_thread thrd)
+{
+    unsigned int ncpus = std::thread::hardware_concurrency();
+    if( ncpus && cpu >= ncpus )
+        throw std::invalid_argument("invalid cpu: " + std::to_string(cpu));
+
+    return _configure_thread( thrd,
+        [=](thread_config& c){ c.cpu = static_cast<int>(cpu); } );
+}
+
+
+bool
+SOB_CLASS::name_thread(std::string name, sob_thread thrd)
+{
+    return _configure_thread( thrd,
+        [&](thread_config& c){ c.name = name; } );
+}
+
+
+template<typename F>
+bool
+SOB_CLASS::_configure_thread(sob_thread thrd, F apply)
+{
+    bool ok = true;
+    std::lock_guard<std::mutex> lock(_thread_config_mtx);
+    if( thrd != sob_thread::async_callback ){
+        apply(_dispatcher_config);
+        /* pool workers are shared w/ other books; leave them alone */
+        ok = !_dispatcher_pool && !_inline_exec
+          && _apply_thread_config( sob_thread::dispatcher,
+                                   _order_dispatcher_thread.native_handle() );
+    }
+    if( thrd != sob_thread::dispatcher ){
+        apply(_async_callback_config);
+        /* if the thread isn't up yet it picks up the config when it is */
+        if( _callback_pool || _inline_exec ){
+            ok = false; // shared w/ other books, or no thread at all
+        }else if( _async_callback_thread_live ){
+            ok = _apply_thread_config( sob_thread::async_callback,
+                                       _async_callback_thread_handle ) && ok;
+        }
     }
+    return ok;
+}
+
+
+// _thread_config_mtx must be held
+bool
+SOB_CLASS::_apply_thread_config( sob_thread thrd,
+                                 std::thread::native_handle_type handle )
+{
+    const thread_config& c = (thrd == sob_thread::dispatcher)
+                           ? _dispatcher_config
+                           : _async_callback_config;
+    bool ok = true;
+    if( c.cpu >= 0 )
+        ok = set_thread_affinity(handle, static_cast<unsigned int>(c.cpu));
+    if( !c.name.empty() )
+        ok = set_thread_name(handle, c.name) && ok;
+    return ok;
 }
 
+
 /*
  *  CURRENTLY working under the constraint that stop priority goes:
  *     low price to high for buys
@@ -868,6 +1830,7 @@ SOB_CLASS::_handle_triggered_stop_chain(plevel plev)
         limit = e.limit;
         cb = e.cb;
         sz = e.sz;
+        _stop_size_change(plev, e.is_buy, sz, false);
 
         /* remove trailing stops (no need to check if is trailing stop) */
         _trailing_stop_erase(id, BuyStops);
@@ -880,12 +1843,16 @@ SOB_CLASS::_handle_triggered_stop_chain(plevel plev)
 
        /* UPDATE! we are creating new id for new exec_cb type (Jan 18) */
         id_new = _generate_id();
+        _client_id_rebind(id, id_new);
+        _owner_erase(cb.owner, id); // new order is bound when it's inserted
 
         if( cb ){
             callback_msg msg = limit ? callback_msg::stop_to_limit
                                      : callback_msg::stop_to_market;
             _push_exec_callback(msg, cb, id, id_new, limit, sz);
         }
+        _order_event(order_event_type::stop_trigger, id, BuyStops, plev, sz,
+                     order::as_order_type(e), id_new);
 
         order_type ot = limit ? order_type::limit : order_type::market;
 
@@ -947,20 +1914,46 @@ SOB_CLASS::_push_external_order( order_type oty,
                                  size_t size,
                                  order_exec_cb_type exec_cb,
                                  const AdvancedOrderTicket& aot,
-                                 id_type id )
+                                 id_type id,
+                                 id_type client_id,
+                                 owner_type owner,
+                                 std::shared_ptr<order_batch_bndl>&& batch,
+                                 std::unique_ptr<pull_filter>&& filter )
 {
     std::promise<T> p;
     std::future<T> f(p.get_future());
     {
-        std::lock_guard<std::mutex> lock(_external_order_queue_mtx);
+        std::unique_lock<std::mutex> lock(_external_order_queue_mtx);
         /* --- CRITICAL SECTION --- */
-        _external_order_queue.emplace(
-            oty, buy, limit, stop, size,
-            order_exec_cb_bndl{exec_cb, detail::promise_helper<T>::callback_type},
-            id, aot, std::move(p) );
+        bool priority_cancel = is_priority_cancel(oty, id, size);
+        /* taking a superseded replace's place never needs admission */
+        bool superseded = _coalesce_replaces && !batch && !filter
+                          && is_replace_or_pull(oty, id, size)
+                          && _supersede_queued_replace(id);
+        if( !superseded && _queue_capacity
+            && _queue_depth() >= _queue_capacity )
+            _admit_external_order(lock, priority_cancel);
+
+        order_exec_cb_bndl cb{exec_cb, detail::promise_helper<T>::callback_type,
+                              owner};
+        if( priority_cancel ){
+            _cancel_order_queue.emplace( oty, buy, limit, stop, size, cb, id,
+                                         aot, client_id, std::move(p) );
+        }else{
+            _external_order_queue.emplace_back( oty, buy, limit, stop, size,
+                                                cb, id, aot, client_id,
+                                                std::move(p), std::move(batch),
+                                                std::move(filter) );
+            if( _coalesce_replaces && is_replace(oty, id) )
+                _queued_replaces[id] = &_external_order_queue.back();
+        }
+        _external_orders_pending = true;
         /* --- CRITICAL SECTION --- */
     }
-    _external_order_queue_cond.notify_one();
+    if( _dispatcher_pool )
+        _schedule_pooled_dispatcher();
+    else
+        _external_order_queue_cond.notify_one();
 
     return f;
 }
@@ -985,21 +1978,26 @@ SOB_CLASS::_push_external_order_sync( order_type oty,
                                       size_t size,
                                       order_exec_cb_type exec_cb,
                                       const AdvancedOrderTicket& aot,
-                                      id_type id )
+                                      id_type id,
+                                      id_type client_id,
+                                      owner_type owner,
+                                      std::shared_ptr<order_batch_bndl> batch,
+                                      std::unique_ptr<pull_filter>&& filter )
 {
-    using T = std::pair<id_type,callback_queue_type>;
+    using T = std::pair<id_type,callback_buffer_type>;
+
+    if( _inline_exec ){
+        return _execute_inline( oty, buy, limit, stop, size, exec_cb, aot, id,
+                                client_id, owner, batch.get(), filter.get() );
+    }
 
     std::future<T> f = _push_external_order<T>(
-        oty, buy, limit, stop, size, exec_cb, aot, id
+        oty, buy, limit, stop, size, exec_cb, aot, id, client_id, owner,
+        std::move(batch), std::move(filter)
         );
 
     T p = f.get();
-
-    for( const auto & e : p.second ){ // no need to protect, copies
-        assert( e.exec_cb );
-        e.exec_cb( e.msg, e.id1, e.id2, e.price, e.sz );
-    }
-
+    _deliver_sync_callbacks( std::move(p.second) );
     return p.first;
 }
 
@@ -1024,14 +2022,71 @@ SOB_CLASS::_push_external_order_async( order_type oty,
                                        size_t size,
                                        order_exec_cb_type exec_cb,
                                        const AdvancedOrderTicket& aot,
-                                       id_type id )
+                                       id_type id,
+                                       id_type client_id,
+                                       owner_type owner,
+                                       std::shared_ptr<order_batch_bndl> batch,
+                                       std::unique_ptr<pull_filter>&& filter )
 {
+    if( _inline_exec ){
+        std::promise<id_type> p;
+        try{
+            p.set_value( _execute_inline(oty, buy, limit, stop, size, exec_cb,
+                                         aot, id, client_id, owner,
+                                         batch.get(), filter.get()) );
+        }catch(...){
+            p.set_exception( std::current_exception() );
+            if( batch )
+                batch->promise.set_exception( std::current_exception() );
+            return p.get_future();
+        }
+        if( batch )
+            batch->promise.set_value( std::move(batch->results) );
+        return p.get_future();
+    }
+
     return _push_external_order<id_type>(
-        oty, buy, limit, stop, size, exec_cb, aot, id
+        oty, buy, limit, stop, size, exec_cb, aot, id, client_id, owner,
+        std::move(batch), std::move(filter)
         );
 }
 
 
+/*
+ * inline books: no queue, no dispatcher, no promise - the window is run
+ * on the caller's thread and ALL callbacks (there's no callback thread)
+ * are run/collected right after it closes, like a sync call's
+ */
+id_type
+SOB_CLASS::_execute_inline( order_type oty,
+                            bool buy,
+                            double limit,
+                            double stop,
+                            size_t size,
+                            order_exec_cb_type exec_cb,
+                            const AdvancedOrderTicket& aot,
+                            id_type id,
+                            id_type client_id,
+                            owner_type owner,
+                            order_batch_bndl *batch,
+                            const pull_filter *filter )
+{
+    assert( _inline_exec );
+
+    callback_buffer_type callbacks;
+    id_type ret = _execute_window(
+        external_order( oty, buy, limit, stop, size,
+                        order_exec_cb_bndl{exec_cb,
+                                           order_exec_cb_bndl::type::synchronous,
+                                           owner},
+                        id, aot, client_id ),
+        batch, filter, clock_type::time_point(), &callbacks
+        );
+    _deliver_sync_callbacks( std::move(callbacks) );
+    return ret;
+}
+
+
 void
 SOB_CLASS::_push_internal_order( order_type oty,
                                  bool buy,
@@ -1165,11 +2220,23 @@ SOB_CLASS::_pull_order(id_type id, bool pull_linked)
 
     using namespace detail;
     try{
+        plevel p = nullptr;
+        bool buy = false;
+        if( !_order_event_subscribers.empty() ){
+            const chain_iter_wrap& iwrap = _from_cache(id);
+            p = iwrap.p;
+            buy = _is_buy_order(iwrap);
+        }
+
         auto bndl = chain<ChainTy>::pop(this, id);
         if( !bndl )
             return false;
 
         _push_exec_callback(callback_msg::cancel, bndl.cb, id, id, 0, 0);
+        _order_event(order_event_type::cancel, id, buy, p, bndl.sz,
+                     order::as_order_type(bndl));
+        _client_id_erase(id);
+        _owner_erase(bndl.cb.owner, id);
 
         if( pull_linked )
             _pull_linked_order<ChainTy>(bndl);
@@ -1188,6 +2255,60 @@ template bool SOB_CLASS::_pull_order<SOB_CLASS::limit_chain_type>(id_type,  bool
 template bool SOB_CLASS::_pull_order<SOB_CLASS::stop_chain_type>(id_type, bool);
 
 
+/*
+ * a smaller size can't make the order cross anything so just adjust the
+ * bndl (keeps its id and place in the chain); a bigger one goes to the
+ * back of the line so pull and re-insert it (w/ its old callback, owner,
+ * client id and advanced condition); AONs always re-insert since a
+ * smaller size might now be fillable
+ *
+ * OCO legs and active bracket/trailing orders are linked to (or own private
+ * state shared with) another order, so resizing one side alone would leave
+ * the pair out of sync and re-inserting would cancel the sibling; reject them
+ */
+id_type
+SOB_CLASS::_modify_order(id_type id, size_t new_size)
+{
+    using namespace detail;
+
+    auto elem = _id_cache.find(id);
+    if( elem == _id_cache.end() )
+        return 0;
+
+    chain_iter_wrap& iwrap = elem->second;
+    if( order::is_OCO(*iwrap) || order::is_active_bracket(*iwrap)
+        || order::is_active_trailing_bracket(*iwrap)
+        || order::is_active_trailing_stop(*iwrap) ){
+        throw advanced_order_error("can't modify linked (OCO) or active "
+                                   "bracket/trailing stop order");
+    }
+
+    if( new_size == iwrap->sz )
+        return id;
+
+    if( new_size < iwrap->sz && !order::is_AON(*iwrap) ){
+        _decr_size(iwrap, iwrap->sz - new_size);
+        return id;
+    }
+
+    order_info oi = order::as_order_info(this, id);
+    external_order e(oi.type, oi.is_buy, oi.limit, oi.stop, new_size,
+                     iwrap->cb, id, oi.advanced, 0);
+    order_queue_elem qe(e, this);
+    id_type client_id = _client_id_of(id);
+
+    if( !_pull_order(id, true) )
+        return 0;
+
+    qe.id = _generate_id();
+    if( client_id )
+        _client_id_bind(client_id, qe.id);
+    _insert_order(qe, id);
+    _client_id_prune(qe.id);
+    return qe.id;
+}
+
+
 template<typename ChainTy>
 void
 SOB_CLASS::_pull_linked_order(typename ChainTy::value_type& bndl)
@@ -1208,6 +2329,103 @@ SOB_CLASS::_in_cache(id_type id) const
     return _id_cache.count(id);
 }
 
+
+id_type
+SOB_CLASS::_resolve_client_id(id_type client_id) const
+{
+    auto elem = _client_ids.find(client_id);
+    if( elem == _client_ids.end() || !_in_cache(elem->second) )
+        return 0;
+    return elem->second;
+}
+
+
+id_type
+SOB_CLASS::_client_id_of(id_type id) const
+{
+    if( _client_ids_by_order.empty() )
+        return 0;
+    auto elem = _client_ids_by_order.find(id);
+    return (elem == _client_ids_by_order.end()) ? 0 : elem->second;
+}
+
+
+void
+SOB_CLASS::_client_id_bind(id_type client_id, id_type id)
+{
+    /* drop any (stale) order the client id still points at */
+    auto elem = _client_ids.find(client_id);
+    if( elem != _client_ids.end() ){
+        _client_ids_by_order.erase(elem->second);
+        elem->second = id;
+    }else{
+        _client_ids.emplace(client_id, id);
+    }
+    _client_ids_by_order[id] = client_id;
+}
+
+
+void
+SOB_CLASS::_client_id_rebind(id_type id_old, id_type id_new)
+{
+    id_type client_id = _client_id_of(id_old);
+    if( client_id )
+        _client_id_bind(client_id, id_new);
+}
+
+
+void
+SOB_CLASS::_client_id_erase(id_type id)
+{
+    if( _client_ids_by_order.empty() )
+        return;
+
+    auto elem = _client_ids_by_order.find(id);
+    if( elem != _client_ids_by_order.end() ){
+        _client_ids.erase(elem->second);
+        _client_ids_by_order.erase(elem);
+    }
+}
+
+
+void
+SOB_CLASS::_client_id_prune(id_type id)
+{
+    if( !_client_ids_by_order.empty() && !_in_cache(id) )
+        _client_id_erase(id);
+}
+
+
+owner_type
+SOB_CLASS::_owner_of(id_type id)
+{
+    auto elem = _id_cache.find(id);
+    return (elem == _id_cache.end()) ? 0 : elem->second->cb.owner;
+}
+
+
+void
+SOB_CLASS::_owner_bind(owner_type owner, id_type id)
+{
+    if( owner )
+        _owner_orders[owner].insert(id);
+}
+
+
+void
+SOB_CLASS::_owner_erase(owner_type owner, id_type id)
+{
+    if( !owner )
+        return;
+
+    auto elem = _owner_orders.find(owner);
+    if( elem != _owner_orders.end() ){
+        elem->second.erase(id);
+        if( elem->second.empty() )
+            _owner_orders.erase(elem);
+    }
+}
+
 bool
 SOB_CLASS::_is_buy_order(plevel p, const stop_bndl& o) const
 { return detail::order::is_buy_stop(o); }
@@ -1217,6 +2435,32 @@ SOB_CLASS::_is_buy_order(plevel p, const limit_bndl& o) const
 { return (p < _ask); }
 
 
+bool
+SOB_CLASS::_is_buy_order(const chain_iter_wrap& iwrap) const
+{
+    switch( iwrap.type ){
+    case chain_iter_wrap::itype::stop:
+        return iwrap.s_iter->is_buy;
+    case chain_iter_wrap::itype::aon_buy:
+        return true;
+    case chain_iter_wrap::itype::aon_sell:
+        return false;
+    default:
+        return _is_buy_order(iwrap.p, *iwrap.l_iter);
+    }
+}
+
+
+void
+SOB_CLASS::_order_resized_event(chain_iter_wrap& iwrap)
+{
+    _order_event(order_event_type::modify, iwrap->id, _is_buy_order(iwrap),
+                 iwrap.p, iwrap->sz, iwrap.is_stop()
+                     ? detail::order::as_order_type(*iwrap.s_iter)
+                     : order_type::limit);
+}
+
+
 double
 SOB_CLASS::_tick_price_or_throw(double price, std::string msg) const
 {
@@ -50,6 +50,7 @@ SOB_CLASS::SimpleOrderbookImpl(TickPrice<TickRatio> min, size_t incr)
             ),
         _base(min)
     {
+        _beg_tick = _base.as_ticks();
     }
 
 
@@ -151,6 +152,7 @@ SOB_CLASS::_grow_book(TickPrice<TickRatio> min, size_t incr, bool at_beg)
     /* book is now in an INVALID state */
 
     _base = min;
+    _beg_tick = _base.as_ticks();
     _beg = &(*_book.begin()) + 1;
     _end = &(*_book.end());
 
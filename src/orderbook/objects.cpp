@@ -371,7 +371,7 @@ SOB_CLASS::order_queue_elem_base_::order_queue_elem_base_()
 
 
 
-SOB_CLASS::external_order_queue_elem::external_order_queue_elem(
+SOB_CLASS::external_order::external_order(
         order_type ot,
         bool is_buy,
         double limit,
@@ -380,10 +380,40 @@ SOB_CLASS::external_order_queue_elem::external_order_queue_elem(
         order_exec_cb_bndl cb,
         id_type id,
         const AdvancedOrderTicket &aot,
-        std::promise<id_type>&& promise )
+        id_type client_id )
     :
         order_queue_elem_base_(ot, is_buy, limit, stop, sz, cb, id),
         aot(aot),
+        client_id(client_id)
+    {}
+
+SOB_CLASS::external_order::external_order()
+    :
+        order_queue_elem_base_(),
+        aot(),
+        client_id(0)
+    {}
+
+
+SOB_CLASS::external_order_queue_elem::external_order_queue_elem(
+        order_type ot,
+        bool is_buy,
+        double limit,
+        double stop,
+        size_t sz,
+        order_exec_cb_bndl cb,
+        id_type id,
+        const AdvancedOrderTicket &aot,
+        id_type client_id,
+        std::promise<id_type>&& promise,
+        std::shared_ptr<order_batch_bndl> batch,
+        std::unique_ptr<pull_filter>&& filter )
+    :
+        external_order(ot, is_buy, limit, stop, sz, cb, id, aot, client_id),
+        batch(batch),
+        filter( std::move(filter) ),
+        queued_at( clock_type::now() ),
+        superseded(false),
         promise_async( std::move(promise) )
     {
         assert( cb.cb_type == order_exec_cb_bndl::type::asynchronous );
@@ -398,11 +428,17 @@ SOB_CLASS::external_order_queue_elem::external_order_queue_elem(
       order_exec_cb_bndl cb,
       id_type id,
       const AdvancedOrderTicket& aot,
-      std::promise<std::pair<id_type, callback_queue_type>>&& promise
+      id_type client_id,
+      std::promise<std::pair<id_type, callback_buffer_type>>&& promise,
+      std::shared_ptr<order_batch_bndl> batch,
+      std::unique_ptr<pull_filter>&& filter
       )
     :
-        order_queue_elem_base_(ot, is_buy, limit, stop, sz, cb, id),
-        aot(aot),
+        external_order(ot, is_buy, limit, stop, sz, cb, id, aot, client_id),
+        batch(batch),
+        filter( std::move(filter) ),
+        queued_at( clock_type::now() ),
+        superseded(false),
         promise_sync( std::move(promise) )
     {
         assert( cb.cb_type == order_exec_cb_bndl::type::synchronous );
@@ -410,8 +446,11 @@ SOB_CLASS::external_order_queue_elem::external_order_queue_elem(
 
 SOB_CLASS::external_order_queue_elem::external_order_queue_elem()
     :
-        order_queue_elem_base_(),
-        aot(),
+        external_order(),
+        batch(),
+        filter(),
+        queued_at(),
+        superseded(false),
         promise_sync()
     {}
 
@@ -429,7 +468,7 @@ SOB_CLASS::external_order_queue_elem::operator=(
     switch( elem.cb.cb_type ){ // from type
     case order_exec_cb_bndl::type::synchronous:
         new (&promise_sync)
-            std::promise<std::pair<id_type, callback_queue_type>>(
+            std::promise<std::pair<id_type, callback_buffer_type>>(
                 std::move(elem.promise_sync)
             );
         break;
@@ -439,8 +478,11 @@ SOB_CLASS::external_order_queue_elem::operator=(
         break;
     };
 
-    order_queue_elem_base_::operator=( std::move(elem) );
-    aot = std::move(elem.aot);
+    external_order::operator=( std::move(elem) );
+    batch = std::move(elem.batch);
+    filter = std::move(elem.filter);
+    queued_at = elem.queued_at;
+    superseded = elem.superseded;
     return *this;
 }
 
@@ -501,7 +543,7 @@ SOB_CLASS::order_queue_elem::order_queue_elem(
 
 
 SOB_CLASS::order_queue_elem::order_queue_elem(
-        const external_order_queue_elem& e,
+        const external_order& e,
         const SOB_CLASS* sob )
     :
         order_queue_elem_base_(e.type, e.is_buy, e.limit, e.stop,
@@ -575,6 +617,45 @@ SOB_CLASS::order_queue_elem::order_queue_elem(
     }
 
 
+SOB_CLASS::top_of_book_record::top_of_book_record()
+    :
+        _pad_front(),
+        seq(0),
+        bid_price(0),
+        bid_size(0),
+        ask_price(0),
+        ask_size(0),
+        last_price(0),
+        last_size(0),
+        volume(0),
+        last_id(0),
+        window(0),
+        _pad_back()
+    {
+    }
+
+
+SOB_CLASS::depth_snapshot_buffer::depth_snapshot_buffer()
+    :
+        bids(),
+        asks(),
+        window(0),
+        readers(0)
+    {
+    }
+
+
+SOB_CLASS::bar_series::bar_series( clock_type::duration interval,
+                                   size_t history )
+    :
+        interval(interval),
+        bars(history),
+        next(0),
+        count(0),
+        notional(0)
+    {
+    }
+
 };
 
 
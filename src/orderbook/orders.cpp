@@ -50,6 +50,15 @@ check_order_params(size_t size, id_type id)
         throw std::invalid_argument("invalid order id(0)");
 }
 
+void
+check_client_id(id_type client_id)
+{
+    if( client_id && !is_client_id(client_id) )
+        throw std::invalid_argument("invalid client id (use make_client_id)");
+    if( client_id == superseded_id )
+        throw std::invalid_argument("invalid client id (reserved)");
+}
+
 template<typename... Args>
 void
 check_market_order_params(const AdvancedOrderTicket& advanced, Args... args)
@@ -86,6 +95,78 @@ check_stop_order_params(const AdvancedOrderTicket& advanced, Args... args)
     }
 }
 
+template<typename OrderTy>
+void
+check_batch_order(const OrderTy& o)
+{
+    switch( o.type ){
+    case order_type::limit:
+        check_order_params(o.sz);
+        break;
+    case order_type::market:
+        check_market_order_params(o.aot, o.sz);
+        break;
+    case order_type::stop:
+    case order_type::stop_limit:
+        check_stop_order_params(o.aot, o.sz);
+        break;
+    default:
+        throw std::invalid_argument("invalid order type for batch");
+    }
+    check_client_id(o.client_id);
+}
+
+void
+check_pull_filter(owner_type owner, const pull_filter& filter)
+{
+    if( !owner )
+        throw std::invalid_argument("invalid owner(0)");
+
+    if( filter.type == order_type::market )
+        throw std::invalid_argument("invalid order type for pull filter");
+
+    if( filter.min_price < 0 || filter.max_price < 0
+        || (filter.max_price && filter.min_price > filter.max_price) )
+        throw std::invalid_argument("invalid price range for pull filter");
+}
+
+/* the default filter takes everything; no need to look at the orders */
+bool
+is_match_all(const pull_filter& filter)
+{
+    return filter.side == side_of_trade::both && !filter.min_price
+        && !filter.max_price && filter.type == order_type::null;
+}
+
+bool
+matches_pull_filter( bool is_buy,
+                     order_type type,
+                     double price, // limit or stop
+                     const pull_filter& filter )
+{
+    switch( filter.side ){
+    case side_of_trade::buy:
+        if( !is_buy )
+            return false;
+        break;
+    case side_of_trade::sell:
+        if( is_buy )
+            return false;
+        break;
+    default: break;
+    }
+
+    if( filter.type != order_type::null && filter.type != type )
+        return false;
+
+    if( filter.min_price && price < filter.min_price )
+        return false;
+    if( filter.max_price && price > filter.max_price )
+        return false;
+
+    return true;
+}
+
 } /* namespace */
 
 
@@ -96,12 +177,16 @@ SOB_CLASS::insert_limit_order( bool buy,
                                double limit,
                                size_t size,
                                order_exec_cb_type exec_cb,
-                               const AdvancedOrderTicket& advanced )
+                               const AdvancedOrderTicket& advanced,
+                               id_type client_id,
+                               owner_type owner )
 {
     check_order_params(size);
+    check_client_id(client_id);
 
     return _push_external_order_sync(order_type::limit, buy, limit, 0, size,
-                                     exec_cb, advanced );
+                                     exec_cb, advanced, 0, client_id,
+                                     owner);
 }
 
 std::future<id_type>
@@ -109,12 +194,16 @@ SOB_CLASS::insert_limit_order_async( bool buy,
                                      double limit,
                                      size_t size,
                                      order_exec_cb_type exec_cb,
-                                     const AdvancedOrderTicket& advanced )
+                                     const AdvancedOrderTicket& advanced,
+                                     id_type client_id,
+                                     owner_type owner )
 {
     check_order_params(size);
+    check_client_id(client_id);
 
     return _push_external_order_async(order_type::limit, buy, limit, 0, size,
-                                     exec_cb, advanced );
+                                     exec_cb, advanced, 0, client_id,
+                                     owner);
 }
 
 
@@ -122,24 +211,32 @@ id_type
 SOB_CLASS::insert_market_order( bool buy,
                                 size_t size,
                                 order_exec_cb_type exec_cb,
-                                const AdvancedOrderTicket& advanced )
+                                const AdvancedOrderTicket& advanced,
+                                id_type client_id,
+                                owner_type owner )
 {
     check_market_order_params(advanced, size);
+    check_client_id(client_id);
 
     return _push_external_order_sync(order_type::market, buy, 0, 0, size,
-                                     exec_cb, advanced);
+                                     exec_cb, advanced, 0, client_id,
+                                     owner);
 }
 
 std::future<id_type>
 SOB_CLASS::insert_market_order_async(bool buy,
                                      size_t size,
                                      order_exec_cb_type exec_cb,
-                                     const AdvancedOrderTicket& advanced )
+                                     const AdvancedOrderTicket& advanced,
+                                     id_type client_id,
+                                     owner_type owner )
 {
     check_market_order_params(advanced, size);
+    check_client_id(client_id);
 
     return _push_external_order_async(order_type::market, buy, 0, 0, size,
-                                      exec_cb, advanced);
+                                      exec_cb, advanced, 0, client_id,
+                                      owner);
 }
 
 
@@ -149,14 +246,17 @@ SOB_CLASS::insert_stop_order( bool buy,
                               double limit,
                               size_t size,
                               order_exec_cb_type exec_cb,
-                              const AdvancedOrderTicket& advanced )
+                              const AdvancedOrderTicket& advanced,
+                              id_type client_id,
+                              owner_type owner )
 {
     check_stop_order_params(advanced, size);
+    check_client_id(client_id);
 
     order_type ot = limit ? order_type::stop_limit : order_type::stop;
 
     return _push_external_order_sync(ot, buy, limit, stop, size, exec_cb,
-                                     advanced);
+                                     advanced, 0, client_id, owner);
 }
 
 std::future<id_type>
@@ -165,14 +265,37 @@ SOB_CLASS::insert_stop_order_async(bool buy,
                          double limit,
                          size_t size,
                          order_exec_cb_type exec_cb,
-                         const AdvancedOrderTicket& advanced )
+                         const AdvancedOrderTicket& advanced,
+                         id_type client_id,
+                         owner_type owner )
 {
     check_stop_order_params(advanced, size);
+    check_client_id(client_id);
 
     order_type ot = limit ? order_type::stop_limit : order_type::stop;
 
     return _push_external_order_async(ot, buy, limit, stop, size, exec_cb,
-                                      advanced);
+                                      advanced, 0, client_id, owner);
+}
+
+
+/* a null order w/ an id and a size is a modify (a pull has no size) */
+id_type
+SOB_CLASS::modify_order(id_type id, size_t new_size)
+{
+    check_order_params(new_size, id);
+
+    return _push_external_order_sync(order_type::null, false, 0, 0, new_size,
+                                     nullptr, AdvancedOrderTicket::null, id);
+}
+
+std::future<id_type>
+SOB_CLASS::modify_order_async(id_type id, size_t new_size)
+{
+    check_order_params(new_size, id);
+
+    return _push_external_order_async(order_type::null, false, 0, 0, new_size,
+                                      nullptr, AdvancedOrderTicket::null, id);
 }
 
 
@@ -195,6 +318,29 @@ SOB_CLASS::pull_order_async(id_type id)
 }
 
 
+size_t
+SOB_CLASS::pull_all(owner_type owner, const pull_filter& filter)
+{
+    check_pull_filter(owner, filter);
+
+    return _push_external_order_sync(order_type::null, false, 0, 0, 0, nullptr,
+                                     AdvancedOrderTicket::null, 0, 0, owner,
+                                     nullptr, std::unique_ptr<pull_filter>(
+                                         new pull_filter(filter)) );
+}
+
+std::future<id_type> // # pulled
+SOB_CLASS::pull_all_async(owner_type owner, const pull_filter& filter)
+{
+    check_pull_filter(owner, filter);
+
+    return _push_external_order_async(order_type::null, false, 0, 0, 0, nullptr,
+                                      AdvancedOrderTicket::null, 0, 0, owner,
+                                      nullptr, std::unique_ptr<pull_filter>(
+                                          new pull_filter(filter)) );
+}
+
+
 id_type
 SOB_CLASS::replace_with_limit_order( id_type id,
                                      bool buy,
@@ -286,15 +432,192 @@ SOB_CLASS::replace_with_stop_order_async(id_type id,
 }
 
 
+std::vector<batch_result>
+SOB_CLASS::insert_orders(const OrderBatch& batch)
+{
+    if( batch.empty() )
+        return {};
+
+    auto bndl = _build_order_batch(batch, order_exec_cb_bndl::type::synchronous);
+    _push_external_order_sync(order_type::null, false, 0, 0, 0, nullptr,
+                              AdvancedOrderTicket::null, 0, 0, 0, bndl);
+    return std::move(bndl->results);
+}
+
+std::future<std::vector<batch_result>>
+SOB_CLASS::insert_orders_async(const OrderBatch& batch)
+{
+    auto bndl = _build_order_batch(batch, order_exec_cb_bndl::type::asynchronous);
+    std::future<std::vector<batch_result>> f( bndl->promise.get_future() );
+    if( batch.empty() )
+        bndl->promise.set_value( {} );
+    else
+        _push_external_order_async(order_type::null, false, 0, 0, 0, nullptr,
+                                   AdvancedOrderTicket::null, 0, 0, 0, bndl);
+    return f;
+}
+
+
+std::shared_ptr<SOB_CLASS::order_batch_bndl>
+SOB_CLASS::_build_order_batch( const OrderBatch& batch,
+                               order_exec_cb_bndl::type cb_type ) const
+{
+    std::shared_ptr<order_batch_bndl> bndl = std::make_shared<order_batch_bndl>();
+    bndl->orders.reserve( batch.size() );
+    for( const auto& e : batch ){
+        /* inline books have no callback thread; everything is 'sync' */
+        bndl->orders.emplace_back( e.type, e.buy, e.limit, e.stop, e.size,
+                                   order_exec_cb_bndl{e.exec_cb,
+                                       _inline_exec
+                                           ? order_exec_cb_bndl::type::synchronous
+                                           : cb_type,
+                                       e.owner},
+                                   0, e.advanced, e.client_id );
+    }
+    return bndl;
+}
+
+
+/*
+ * called by dispatcher thread; each order is checked/executed as if it
+ * came in on its own but the window doesn't close until the batch is done,
+ * an exception only fails the order that threw it
+ */
+id_type
+SOB_CLASS::_execute_order_batch(order_batch_bndl& bndl)
+{
+    bndl.results.resize( bndl.orders.size() );
+    for( size_t i = 0; i < bndl.orders.size(); ++i ){
+        try{
+            check_batch_order( bndl.orders[i] );
+            bndl.results[i].id = _execute_external_order( bndl.orders[i] );
+        }catch(...){
+            while( !_internal_order_queue.empty() )
+                _internal_order_queue.pop();
+            bndl.results[i].error = std::current_exception();
+        }
+    }
+    return bndl.orders.size();
+}
+
+
+/*
+ * called by dispatcher thread; matches are collected first (pulls erase
+ * from the owner's list) and pulled oldest first, their cancel callbacks
+ * all go out at the end of this one window
+ */
+size_t
+SOB_CLASS::_execute_owner_pull(owner_type owner, const pull_filter& filter)
+{
+    using namespace detail;
+
+    auto elem = _owner_orders.find(owner);
+    if( elem == _owner_orders.end() )
+        return 0;
+
+    bool match_all = is_match_all(filter);
+    std::vector<id_type> ids;
+    auto& orders = elem->second;
+    for( auto iter = orders.begin(); iter != orders.end(); ){
+        auto order = _id_cache.find(*iter);
+        if( order == _id_cache.end() ){
+            iter = orders.erase(iter);
+            continue;
+        }
+        /* straight from the chain; don't build an order_info for each */
+        const chain_iter_wrap& iwrap = order->second;
+        if( match_all
+            || matches_pull_filter(_is_buy_order(iwrap),
+                                   iwrap.is_stop()
+                                       ? order::as_order_type(*iwrap.s_iter)
+                                       : order_type::limit,
+                                   _itop(iwrap.p), filter) ){
+            ids.push_back(*iter);
+        }
+        ++iter;
+    }
+    if( orders.empty() )
+        _owner_orders.erase(elem);
+
+    size_t n = 0;
+    for( id_type id : ids ){
+        /* an earlier pull may have taken a linked(OCO) order w/ it */
+        if( _pull_order(id, true) )
+            ++n;
+    }
+    return n;
+}
+
+
 order_info
 SOB_CLASS::get_order_info(id_type id) const
 {
     std::lock_guard<std::mutex> lock(_master_mtx);
     /* --- CRITICAL SECTION --- */
+    if( is_client_id(id) )
+        id = _resolve_client_id(id);
     return detail::order::as_order_info(this, id);
     /* --- CRITICAL SECTION --- */
 }
 
+
+/* like get_order_info but w/o building an AdvancedOrderTicket for each */
+size_t
+SOB_CLASS::get_order_status(const id_type *ids,
+                            size_t n,
+                            order_status *out) const
+{
+    using namespace detail;
+
+    if( n && (!ids || !out) )
+        throw std::invalid_argument("ids/out == nullptr");
+
+    size_t nfound = 0;
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    /* --- CRITICAL SECTION --- */
+    for( size_t i = 0; i < n; ++i ){
+        order_status& s = out[i];
+        s = order_status();
+        s.id = is_client_id(ids[i]) ? _resolve_client_id(ids[i]) : ids[i];
+
+        auto elem = _id_cache.find(s.id);
+        if( elem == _id_cache.end() )
+            continue;
+
+        const chain_iter_wrap& iwrap = elem->second;
+        const _order_bndl *b = nullptr;
+        switch( iwrap.type ){
+        case chain_iter_wrap::itype::limit:
+            b = &*iwrap.l_iter;
+            s.type = order_type::limit;
+            s.is_buy = _is_buy_order(iwrap.p, *iwrap.l_iter);
+            s.limit_tick = _tick(iwrap.p);
+            break;
+        case chain_iter_wrap::itype::stop:
+            b = &*iwrap.s_iter;
+            s.type = order::as_order_type(*iwrap.s_iter);
+            s.is_buy = iwrap.s_iter->is_buy;
+            s.stop_tick = _tick(iwrap.p);
+            if( iwrap.s_iter->limit )
+                s.limit_tick = _tick( _ptoi(iwrap.s_iter->limit) );
+            break;
+        case chain_iter_wrap::itype::aon_buy: /* no break */
+        case chain_iter_wrap::itype::aon_sell:
+            b = &*iwrap.a_iter;
+            s.type = order_type::limit;
+            s.is_buy = iwrap.is_aon_buy();
+            s.limit_tick = _tick(iwrap.p);
+            break;
+        }
+        s.size = b->sz;
+        s.condition = b->condition;
+        s.trigger = b->trigger;
+        ++nfound;
+    }
+    return nfound;
+    /* --- CRITICAL SECTION --- */
+}
+
 }; /* sob */
 
 #undef SOB_CLASS
@@ -36,127 +36,458 @@ namespace sob{
 
 double
 SOB_CLASS::bid_price() const
-{
-    using namespace detail;
+{ return _read_top_of_book().bid_price; }
+
+
+double
+SOB_CLASS::ask_price() const
+{ return _read_top_of_book().ask_price; }
+
+
+double
+SOB_CLASS::last_price() const
+{ return _read_top_of_book().last_price; }
+
 
+double
+SOB_CLASS::min_price() const
+{
     std::lock_guard<std::mutex> lock(_master_mtx);
     /* --- CRITICAL SECTION --- */
-    for( plevel h = _bid; h >= _low_buy_limit; --h ){
-        if( chain<limit_chain_type>::atleast_if( h, 1, order::is_not_AON ) )
-            return _itop(h);
-    }
-    return 0;
+    return _itop(_beg);
     /* --- CRITICAL SECTION --- */
 }
 
+
 double
-SOB_CLASS::ask_price() const
+SOB_CLASS::max_price() const
+{
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    /* --- CRITICAL SECTION --- */
+    return _itop(_end - 1);
+    /* --- CRITICAL SECTION --- */
+}
+
+
+size_t
+SOB_CLASS::bid_size() const
+{ return _read_top_of_book().bid_size; }
+
+
+size_t
+SOB_CLASS::ask_size() const
+{ return _read_top_of_book().ask_size; }
+
+
+size_t
+SOB_CLASS::last_size() const
+{ return _read_top_of_book().last_size; }
+
+
+unsigned long long
+SOB_CLASS::volume() const
+{ return _read_top_of_book().volume; }
+
+
+id_type
+SOB_CLASS::last_id() const
+{ return _read_top_of_book().last_id; }
+
+
+top_of_book
+SOB_CLASS::get_top_of_book() const
+{ return _read_top_of_book(); }
+
+
+// called by dispatcher (w/ _master_mtx held) at the end of each window
+void
+SOB_CLASS::_publish_top_of_book()
 {
     using namespace detail;
 
+    double bid_price = 0;
+    size_t bid_size = 0;
+    for( plevel h = _bid; h >= _low_buy_limit && bid_size == 0; --h ){
+        bid_size = chain<limit_chain_type>::size_if( h, order::is_not_AON );
+        if( bid_size )
+            bid_price = _itop(h);
+    }
+
+    double ask_price = 0;
+    size_t ask_size = 0;
+    for( plevel l = _ask; l <= _high_sell_limit && ask_size == 0; ++l ){
+        ask_size = chain<limit_chain_type>::size_if( l, order::is_not_AON );
+        if( ask_size )
+            ask_price = _itop(l);
+    }
+
+    top_of_book_record& r = _top_of_book;
+    unsigned long long seq = r.seq.load(std::memory_order_relaxed);
+    r.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    r.bid_price.store(bid_price, std::memory_order_relaxed);
+    r.bid_size.store(bid_size, std::memory_order_relaxed);
+    r.ask_price.store(ask_price, std::memory_order_relaxed);
+    r.ask_size.store(ask_size, std::memory_order_relaxed);
+    r.last_price.store( (_last >= _beg && _last < _end) ? _itop(_last) : 0.0,
+                        std::memory_order_relaxed );
+    r.last_size.store(_last_size, std::memory_order_relaxed);
+    r.volume.store(_total_volume, std::memory_order_relaxed);
+    r.last_id.store(_last_id, std::memory_order_relaxed);
+    r.window.store(r.window.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_relaxed);
+
+    r.seq.store(seq + 2, std::memory_order_release);
+}
+
+
+top_of_book
+SOB_CLASS::_read_top_of_book() const
+{
+    const top_of_book_record& r = _top_of_book;
+    top_of_book tob;
+    for( ; ; ){
+        unsigned long long seq = r.seq.load(std::memory_order_acquire);
+        if( seq & 1 ){
+            std::this_thread::yield(); // dispatcher mid-write
+            continue;
+        }
+        tob.bid_price = r.bid_price.load(std::memory_order_relaxed);
+        tob.bid_size = r.bid_size.load(std::memory_order_relaxed);
+        tob.ask_price = r.ask_price.load(std::memory_order_relaxed);
+        tob.ask_size = r.ask_size.load(std::memory_order_relaxed);
+        tob.last_price = r.last_price.load(std::memory_order_relaxed);
+        tob.last_size = r.last_size.load(std::memory_order_relaxed);
+        tob.volume = r.volume.load(std::memory_order_relaxed);
+        tob.last_id = r.last_id.load(std::memory_order_relaxed);
+        tob.window = r.window.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if( r.seq.load(std::memory_order_relaxed) == seq )
+            return tob;
+    }
+}
+
+
+depth_snapshot
+SOB_CLASS::get_depth_snapshot() const
+{
+    const depth_snapshot_buffer *b;
+    for( ; ; ){
+        b = _depth_snapshots + _depth_snapshot_current.load();
+        ++(b->readers);
+        /* make sure it wasn't swapped out before we registered */
+        if( _depth_snapshots + _depth_snapshot_current.load() == b )
+            break;
+        --(b->readers);
+    }
+
+    depth_snapshot ds;
+    ds.bids = b->bids;
+    ds.asks = b->asks;
+    ds.window = b->window;
+    --(b->readers);
+    return ds;
+}
+
+
+void
+SOB_CLASS::set_depth_snapshot_levels(size_t n)
+{
     std::lock_guard<std::mutex> lock(_master_mtx);
     /* --- CRITICAL SECTION --- */
-    for( plevel l = _ask; l <= _high_sell_limit; ++l ){
-        if( chain<limit_chain_type>::atleast_if( l, 1, order::is_not_AON ) )
-            return _itop(l);
+    _depth_snapshot_levels = n;
+    _depth_scratch_bids.reserve(n);
+    _depth_scratch_asks.reserve(n);
+    for( auto& b : _depth_snapshots ){
+        b.bids.reserve(n);
+        b.asks.reserve(n);
     }
-    return 0;
+    _publish_depth_snapshot(true);
     /* --- CRITICAL SECTION --- */
 }
 
 
-double
-SOB_CLASS::last_price() const
+size_t
+SOB_CLASS::get_depth_snapshot_levels() const
 {
     std::lock_guard<std::mutex> lock(_master_mtx);
     /* --- CRITICAL SECTION --- */
-    return (_last >= _beg && _last < _end) ? _itop(_last) : 0.0;
+    return _depth_snapshot_levels;
     /* --- CRITICAL SECTION --- */
 }
 
 
-double
-SOB_CLASS::min_price() const
+queue_time_stats
+SOB_CLASS::get_cancel_queue_time_stats() const
 {
     std::lock_guard<std::mutex> lock(_master_mtx);
     /* --- CRITICAL SECTION --- */
-    return _itop(_beg);
+    return _cancel_queue_times;
     /* --- CRITICAL SECTION --- */
 }
 
 
-double
-SOB_CLASS::max_price() const
+queue_time_stats
+SOB_CLASS::get_order_queue_time_stats() const
 {
     std::lock_guard<std::mutex> lock(_master_mtx);
     /* --- CRITICAL SECTION --- */
-    return _itop(_end - 1);
+    return _order_queue_times;
     /* --- CRITICAL SECTION --- */
 }
 
 
-size_t
-SOB_CLASS::bid_size() const
+void
+SOB_CLASS::reset_queue_time_stats()
 {
-    using namespace detail;
-
     std::lock_guard<std::mutex> lock(_master_mtx);
     /* --- CRITICAL SECTION --- */
-    size_t tot = 0;
-    for( plevel h = _bid; h >= _low_buy_limit && tot == 0; --h ){
-        tot = chain<limit_chain_type>::size_if( h, order::is_not_AON );
-    }
-    return tot;
+    _cancel_queue_times = queue_time_stats();
+    _order_queue_times = queue_time_stats();
     /* --- CRITICAL SECTION --- */
 }
 
 
-size_t
-SOB_CLASS::ask_size() const
+// _master_mtx must be held
+void
+SOB_CLASS::_publish_depth_snapshot(bool force)
+{
+    using namespace detail;
+
+    if( !_depth_snapshot_levels && !force )
+        return;
+
+    auto& bids = _depth_scratch_bids;
+    auto& asks = _depth_scratch_asks;
+    bids.clear();
+    asks.clear();
+
+    for( plevel h = _bid;
+         h >= _low_buy_limit && bids.size() < _depth_snapshot_levels;
+         --h )
+    {
+        size_t sz = chain<limit_chain_type>::size_if(h, order::is_not_AON);
+        if( sz )
+            bids.emplace_back(_itop(h), sz);
+    }
+
+    for( plevel l = _ask;
+         l <= _high_sell_limit && asks.size() < _depth_snapshot_levels;
+         ++l )
+    {
+        size_t sz = chain<limit_chain_type>::size_if(l, order::is_not_AON);
+        if( sz )
+            asks.emplace_back(_itop(l), sz);
+    }
+
+    int cur = _depth_snapshot_current.load(std::memory_order_relaxed);
+    const depth_snapshot_buffer& current = _depth_snapshots[cur];
+    if( !force && bids == current.bids && asks == current.asks )
+        return;
+
+    /* readers only pin the other buffer for as long as it takes to copy it */
+    depth_snapshot_buffer& next = _depth_snapshots[cur ^ 1];
+    while( next.readers.load() )
+        std::this_thread::yield();
+
+    next.bids.swap(bids);
+    next.asks.swap(asks);
+    next.window = _top_of_book.window.load(std::memory_order_relaxed);
+    _depth_snapshot_current.store(cur ^ 1);
+}
+
+
+// _master_mtx must be held
+void
+SOB_CLASS::_publish_depth_deltas()
 {
     using namespace detail;
 
+    if( _depth_dirty.empty() )
+        return;
+
+    unsigned long long seq = _depth_delta_seq + 1;
+    bool changed = false;
+    auto emit = [&](bool bid, double price, size_t sz){
+        depth_delta d(seq, bid ? side_of_market::bid : side_of_market::ask,
+                      price, sz);
+        for( DepthDeltaRing *r : _depth_subscribers )
+            r->_push(d);
+        changed = true;
+    };
+
+    for( plevel p : _depth_dirty ){
+        p->l2_dirty = false;
+        size_t sz = chain<limit_chain_type>::size_if(p, order::is_not_AON);
+        bool bid = p < _ask; // same as market_depth
+        if( sz == p->l2_size && (!sz || bid == p->l2_bid) )
+            continue;
+        double price = _itop(p);
+        /* if it crossed to the other side the old side goes to zero first */
+        if( p->l2_size && (!sz || bid != p->l2_bid) )
+            emit(p->l2_bid, price, 0);
+        if( sz )
+            emit(bid, price, sz);
+        p->l2_size = sz;
+        p->l2_bid = bid;
+    }
+    _depth_dirty.clear();
+
+    if( changed ){
+        _depth_delta_seq = seq;
+        for( DepthDeltaRing *r : _depth_subscribers )
+            r->_publish();
+    }
+}
+
+
+void
+SOB_CLASS::subscribe_depth_deltas(DepthDeltaRing *ring)
+{
+    using namespace detail;
+
+    if( !ring )
+        throw std::invalid_argument("null depth delta ring");
+
     std::lock_guard<std::mutex> lock(_master_mtx);
     /* --- CRITICAL SECTION --- */
-    size_t tot = 0;
-    for( plevel l = _ask; l <= _high_sell_limit && tot == 0; ++l ){
-        tot = chain<limit_chain_type>::size_if( l, order::is_not_AON );
+    if( ring->_subscribed )
+        throw std::invalid_argument("depth delta ring already subscribed");
+
+    /* levels weren't tracked while no one was listening */
+    if( _depth_subscribers.empty() ){
+        for( plevel p = _beg; p < _end; ++p ){
+            p->l2_size = chain<limit_chain_type>::size_if(p, order::is_not_AON);
+            p->l2_bid = p < _ask;
+            p->l2_dirty = false;
+        }
     }
-    return tot;
+
+    /* start the new subscriber off w/ the whole book at the current seq */
+    plevel l, h;
+    std::tie(l,h) = range<>::template get<limit_chain_type>(this);
+    for( ; l <= h; ++l ){
+        if( l->l2_size ){
+            ring->_push( depth_delta(_depth_delta_seq,
+                                     l->l2_bid ? side_of_market::bid
+                                               : side_of_market::ask,
+                                     _itop(l), l->l2_size) );
+        }
+    }
+    ring->_publish();
+
+    ring->_subscribed = true;
+    _depth_subscribers.push_back(ring);
     /* --- CRITICAL SECTION --- */
 }
 
 
-size_t
-SOB_CLASS::last_size() const
+bool
+SOB_CLASS::unsubscribe_depth_deltas(DepthDeltaRing *ring)
 {
     std::lock_guard<std::mutex> lock(_master_mtx);
     /* --- CRITICAL SECTION --- */
-    return _last_size;
+    auto iter = std::find(_depth_subscribers.begin(), _depth_subscribers.end(),
+                          ring);
+    if( iter == _depth_subscribers.end() )
+        return false;
+    _depth_subscribers.erase(iter);
+    ring->_subscribed = false;
+    return true;
     /* --- CRITICAL SECTION --- */
 }
 
 
-unsigned long long
-SOB_CLASS::volume() const
+// _master_mtx must be held
+void
+SOB_CLASS::_publish_order_events()
 {
+    if( !_order_events_unpublished )
+        return;
+    for( OrderEventRing *r : _order_event_subscribers )
+        r->_publish();
+    _order_events_unpublished = false;
+}
+
+
+void
+SOB_CLASS::subscribe_order_events(OrderEventRing *ring)
+{
+    if( !ring )
+        throw std::invalid_argument("null order event ring");
+
     std::lock_guard<std::mutex> lock(_master_mtx);
     /* --- CRITICAL SECTION --- */
-    return _total_volume;
+    if( ring->_subscribed )
+        throw std::invalid_argument("order event ring already subscribed");
+
+    _snapshot_order_events(ring);
+    ring->_publish();
+
+    ring->_subscribed = true;
+    _order_event_subscribers.push_back(ring);
     /* --- CRITICAL SECTION --- */
 }
 
 
-id_type
-SOB_CLASS::last_id() const
+bool
+SOB_CLASS::unsubscribe_order_events(OrderEventRing *ring)
 {
     std::lock_guard<std::mutex> lock(_master_mtx);
     /* --- CRITICAL SECTION --- */
-    return _last_id;
+    auto iter = std::find(_order_event_subscribers.begin(),
+                          _order_event_subscribers.end(), ring);
+    if( iter == _order_event_subscribers.end() )
+        return false;
+    _order_event_subscribers.erase(iter);
+    ring->_subscribed = false;
+    return true;
     /* --- CRITICAL SECTION --- */
 }
 
 
+/* an add for every order in the book, in time priority at each level */
+void
+SOB_CLASS::_snapshot_order_events(OrderEventRing *ring)
+{
+    using namespace detail;
+
+    order_event e;
+    e.parent_id = 0;
+    e.window = _top_of_book.window.load(std::memory_order_relaxed);
+    e.type = order_event_type::add;
+
+    auto add = [&](plevel p, const _order_bndl& b, bool buy, order_type ot){
+        e.id = b.id;
+        e.tick = _beg_tick + (p - _beg);
+        e.size = b.sz;
+        e.buy = buy;
+        e.order = ot;
+        ring->_push(e);
+    };
+
+    for( plevel p = _beg; p < _end; ++p ){
+        if( !p->limits.empty() ){
+            for( const limit_bndl& b : *p->limits )
+                add(p, b, _is_buy_order(p, b), order_type::limit);
+        }
+        if( !p->aon_buys.empty() ){
+            for( const aon_bndl& b : *p->aon_buys )
+                add(p, b, true, order_type::limit);
+        }
+        if( !p->aon_sells.empty() ){
+            for( const aon_bndl& b : *p->aon_sells )
+                add(p, b, false, order_type::limit);
+        }
+        if( !p->stops.empty() ){
+            for( const stop_bndl& b : *p->stops )
+                add(p, b, b.is_buy, order::as_order_type(b));
+        }
+    }
+}
+
+
 const std::vector<timesale_entry_type>&
 SOB_CLASS::time_and_sales() const
 {
@@ -167,6 +498,28 @@ SOB_CLASS::time_and_sales() const
 }
 
 
+size_t
+SOB_CLASS::bars(clock_type::duration interval, bar *out, size_t n) const
+{
+    if( n && !out )
+        throw std::invalid_argument("out == nullptr");
+
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    /* --- CRITICAL SECTION --- */
+    for( const bar_series& s : _bar_series ){
+        if( s.interval != interval )
+            continue;
+        size_t cap = s.bars.size();
+        n = std::min(n, s.count);
+        for( size_t i = 0; i < n; ++i )
+            out[i] = s.bars[(s.next + cap - n + i) % cap];
+        return n;
+    }
+    throw std::invalid_argument("bar interval not kept");
+    /* --- CRITICAL SECTION --- */
+}
+
+
 void
 SOB_CLASS::dump_internal_pointers(std::ostream& out) const
 {
@@ -258,6 +611,47 @@ template std::map<double,size_t>
 SOB_CLASS::_limit_depth<side_of_market::ask>(size_t) const;
 
 
+/* _limit_depth for one side into a flat array, best price first */
+template<bool BuySide>
+size_t
+SOB_CLASS::_limit_depth_levels(depth_level *levels, size_t n) const
+{
+    using namespace detail;
+
+    if( n && !levels )
+        throw std::invalid_argument("levels == nullptr");
+
+    size_t i = 0;
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    /* --- CRITICAL SECTION --- */
+    plevel p = BuySide ? _bid : _ask;
+    plevel stop = BuySide ? _low_buy_limit : _high_sell_limit;
+    for( ; i < n && (BuySide ? p >= stop : p <= stop);
+         BuySide ? --p : ++p )
+    {
+        const limit_chain_type *c = p->limits.get();
+        if( !c )
+            continue;
+        size_t sz = 0, count = 0;
+        for( const limit_bndl& b : *c ){
+            if( order::is_not_AON(b) ){
+                sz += b.sz;
+                ++count;
+            }
+        }
+        if( sz )
+            levels[i++] = {_itop(p), sz, count};
+    }
+    return i;
+    /* --- CRITICAL SECTION --- */
+}
+template size_t
+SOB_CLASS::_limit_depth_levels<true>(depth_level*, size_t) const;
+
+template size_t
+SOB_CLASS::_limit_depth_levels<false>(depth_level*, size_t) const;
+
+
 std::map<double, std::pair<size_t,size_t>>
 SOB_CLASS::aon_market_depth() const
 {
@@ -292,6 +686,126 @@ SOB_CLASS::aon_market_depth() const
 }
 
 
+/*
+ * walk the book like _trade<!BuyMarket> does for a market order: at each
+ * level the AON chain then the limit chain, AONs only if they fit in
+ * what's left; doesn't include _match_aon_orders_PRE_trade, which can
+ * also fill an overlapping AON partly against the other side
+ */
+template<bool BuyMarket>
+fill_estimate
+SOB_CLASS::_estimate_fill(size_t size) const
+{
+    using namespace detail;
+    using AON = exec::aon<!BuyMarket>;
+    using CORE = exec::core<!BuyMarket>;
+    using LIMIT = exec::limit<!BuyMarket>;
+
+    if( size == 0 )
+        throw std::invalid_argument("invalid order size");
+
+    fill_estimate fe;
+    double notional = 0;
+    size_t left = size;
+
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    /* --- CRITICAL SECTION --- */
+    for( plevel p = CORE::begin(this);
+         left && CORE::inside_of(p, CORE::end(this));
+         p = CORE::next_or_jump(this, p) )
+    {
+        size_t before = left;
+        if( AON::in_window(this, p) ){
+            const aon_chain_type *ac = p->aon_chain<!BuyMarket>().get();
+            if( ac ){
+                for( const aon_bndl& b : *ac ){
+                    if( left >= b.sz )
+                        left -= b.sz;
+                }
+            }
+        }
+        if( LIMIT::in_window(this, p) ){
+            const limit_chain_type *lc = p->limits.get();
+            if( lc ){
+                for( const limit_bndl& b : *lc ){
+                    if( !left )
+                        break;
+                    if( order::is_not_AON(b) )
+                        left -= std::min(left, b.sz);
+                    else if( left >= b.sz )
+                        left -= b.sz;
+                }
+            }
+        }
+        if( left < before ){
+            double price = _itop(p);
+            notional += price * (before - left);
+            fe.worst_price = price;
+            ++fe.levels;
+        }
+    }
+    /* --- CRITICAL SECTION --- */
+
+    fe.filled = size - left;
+    if( fe.filled )
+        fe.vwap = notional / fe.filled;
+    return fe;
+}
+template fill_estimate SOB_CLASS::_estimate_fill<true>(size_t) const;
+template fill_estimate SOB_CLASS::_estimate_fill<false>(size_t) const;
+
+
+/* from the per-level stop aggregates; doesn't walk the stop chains */
+std::map<double, std::pair<size_t,size_t>>
+SOB_CLASS::stop_depth(size_t depth) const
+{
+    using namespace detail;
+
+    std::map<double, std::pair<size_t, size_t>> md;
+
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    /* --- CRITICAL SECTION --- */
+    plevel l, h;
+    std::tie(l,h) = range<>::template get<stop_chain_type>(this);
+    if( _last ){
+        if( _last > l && static_cast<size_t>(_last - l) > depth )
+            l = _last - depth;
+        if( h > _last && static_cast<size_t>(h - _last) > depth )
+            h = _last + depth;
+    }
+    for( ; l <= h; ++l ){
+        if( l->buy_stop_size || l->sell_stop_size )
+            md[_itop(l)] = {l->buy_stop_size, l->sell_stop_size};
+    }
+    return md;
+    /* --- CRITICAL SECTION --- */
+}
+
+
+size_t
+SOB_CLASS::total_buy_stop_size() const
+{
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    return _total_buy_stop_size;
+}
+
+
+size_t
+SOB_CLASS::total_sell_stop_size() const
+{
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    return _total_sell_stop_size;
+}
+
+
+size_t
+SOB_CLASS::total_stop_size() const
+{
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    return _total_buy_stop_size + _total_sell_stop_size;
+}
+
+
 /* total size of limit/stop/aon buys/sells/both*/
 template<side_of_trade Side, typename ChainTy>
 size_t
@@ -455,4 +969,179 @@ template void
 SOB_CLASS::_dump_aon_orders<side_of_trade::sell>(std::ostream&) const;
 
 
+template<bool BuySide>
+bool
+SOB_CLASS::_visit_limit_levels( double min_price,
+                                double max_price,
+                                visitor_fn_type<level_view> visitor,
+                                void *arg,
+                                size_t& n ) const
+{
+    using namespace detail;
+
+    plevel p = BuySide ? _bid : _ask;
+    plevel stop = BuySide ? _low_buy_limit : _high_sell_limit;
+    for( ; BuySide ? p >= stop : p <= stop; BuySide ? --p : ++p ){
+        const limit_chain_type *c = p->limits.get();
+        if( !c )
+            continue;
+        size_t sz = 0, count = 0;
+        for( const limit_bndl& b : *c ){
+            if( order::is_not_AON(b) ){
+                sz += b.sz;
+                ++count;
+            }
+        }
+        if( !sz )
+            continue;
+
+        double price = _itop(p);
+        /* best price first; past the far end of the range we're done */
+        if( BuySide ? (min_price && price < min_price)
+                    : (max_price && price > max_price) )
+            break;
+        if( BuySide ? (max_price && price > max_price)
+                    : (min_price && price < min_price) )
+            continue;
+
+        level_view v = {price, _tick(p), BuySide ? side_of_market::bid
+                                                 : side_of_market::ask,
+                        sz, count};
+        ++n;
+        if( !visitor(arg, v) )
+            return false;
+    }
+    return true;
+}
+
+
+size_t
+SOB_CLASS::_visit_levels( side_of_market side,
+                          double min_price,
+                          double max_price,
+                          visitor_fn_type<level_view> visitor,
+                          void *arg ) const
+{
+    if( min_price < 0 || max_price < 0
+        || (max_price && min_price > max_price) )
+        throw std::invalid_argument("invalid price range");
+
+    size_t n = 0;
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    /* --- CRITICAL SECTION --- */
+    if( side != side_of_market::ask
+        && !_visit_limit_levels<true>(min_price, max_price, visitor, arg, n) )
+        return n;
+    if( side != side_of_market::bid )
+        _visit_limit_levels<false>(min_price, max_price, visitor, arg, n);
+    return n;
+    /* --- CRITICAL SECTION --- */
+}
+
+
+size_t
+SOB_CLASS::_visit_orders( side_of_trade side,
+                          double min_price,
+                          double max_price,
+                          order_type type,
+                          visitor_fn_type<order_view> visitor,
+                          void *arg ) const
+{
+    using namespace detail;
+
+    if( type == order_type::market )
+        throw std::invalid_argument("invalid order type");
+    if( min_price < 0 || max_price < 0
+        || (max_price && min_price > max_price) )
+        throw std::invalid_argument("invalid price range");
+
+    bool limits = (type == order_type::null || type == order_type::limit);
+    bool stops = (type != order_type::limit);
+    bool buys = (side != side_of_trade::sell);
+    bool sells = (side != side_of_trade::buy);
+
+    auto want = [&](order_type t, bool buy){
+        return (buy ? buys : sells)
+            && (type == order_type::null || type == t);
+    };
+
+    size_t n = 0;
+    std::lock_guard<std::mutex> lock(_master_mtx);
+    /* --- CRITICAL SECTION --- */
+
+    plevel l1, h1, l2, h2;
+    std::tie(l1,h1) = range<>::template
+        get<limit_chain_type, aon_chain_type>(this);
+    std::tie(l2,h2) = range<>::template get<stop_chain_type>(this);
+    if( !limits ){
+        l1 = _end;
+        h1 = _beg - 1;
+    }
+    if( !stops ){
+        l2 = _end;
+        h2 = _beg - 1;
+    }
+
+    plevel l = std::min(l1, l2);
+    for( plevel h = std::max(h1, h2); h >= l; --h ){
+        const limit_chain_type *lc = limits ? h->limits.get() : nullptr;
+        const aon_chain_type *abc = limits ? h->aon_buys.get() : nullptr;
+        const aon_chain_type *asc = limits ? h->aon_sells.get() : nullptr;
+        const stop_chain_type *sc = stops ? h->stops.get() : nullptr;
+        if( (!lc || lc->empty()) && (!abc || abc->empty())
+            && (!asc || asc->empty()) && (!sc || sc->empty()) )
+            continue;
+
+        double price = _itop(h);
+        if( max_price && price > max_price )
+            continue;
+        if( min_price && price < min_price )
+            break;
+        long long tick = _tick(h);
+
+        if( lc ){
+            bool buy = (h < _ask);
+            if( want(order_type::limit, buy) ){
+                for( const limit_bndl& b : *lc ){
+                    order_view v = {b.id, price, 0, tick, b.sz,
+                                    order_type::limit, buy, b.condition,
+                                    b.trigger};
+                    ++n;
+                    if( !visitor(arg, v) )
+                        return n;
+                }
+            }
+        }
+
+        for( const aon_chain_type *c : {abc, asc} ){
+            bool buy = (c == abc);
+            if( !c || !want(order_type::limit, buy) )
+                continue;
+            for( const aon_bndl& b : *c ){
+                order_view v = {b.id, price, 0, tick, b.sz, order_type::limit,
+                                buy, b.condition, b.trigger};
+                ++n;
+                if( !visitor(arg, v) )
+                    return n;
+            }
+        }
+
+        if( sc ){
+            for( const stop_bndl& b : *sc ){
+                order_type t = order::as_order_type(b);
+                if( !want(t, b.is_buy) )
+                    continue;
+                order_view v = {b.id, b.limit, price, tick, b.sz, t,
+                                b.is_buy, b.condition, b.trigger};
+                ++n;
+                if( !visitor(arg, v) )
+                    return n;
+            }
+        }
+    }
+    return n;
+    /* --- CRITICAL SECTION --- */
+}
+
+
 } /* sob */
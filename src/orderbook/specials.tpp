@@ -512,6 +512,7 @@ protected:
              std::forward_as_tuple(bndl.id),
              std::forward_as_tuple(iter, args...)
          );       
+        sob->_owner_bind(iter->cb.owner, iter->id);
     }
     
 public:
@@ -572,8 +573,13 @@ public:
     static void
     push(sob_class *sob, plevel p, limit_bndl&& bndl)
     {       
+        id_type id = bndl.id;
+        size_t sz = bndl.sz;
         base_type::push(sob, p->limits, std::move(bndl), p);
         exec::limit<BuyLimit>::adjust_state_after_insert(sob, p);
+        sob->_depth_touch(p);
+        sob->_order_event(order_event_type::add, id, BuyLimit, p, sz,
+                          order_type::limit, sob->_order_event_parent);
     }
 
     static limit_bndl
@@ -584,6 +590,7 @@ public:
                 
         limit_bndl bndl = *(iwrap.l_iter); // copy
         plevel p = iwrap.p;
+        sob->_depth_touch(p);
 
         erase(p, iwrap.l_iter); // first
         sob->_id_cache.erase(id);  // second
@@ -636,9 +643,13 @@ struct chain<typename sob_types::aon_chain_type, false>
     static void
     push(sob_class *sob, plevel p, aon_bndl&& bndl )
     {
+        id_type id = bndl.id;
+        size_t sz = bndl.sz;
         base_type::push(sob, p->aon_chain<BuyLimit>(), std::move(bndl), p,
                         BuyLimit);
         exec::aon<BuyLimit>::adjust_state_after_insert(sob, p);
+        sob->_order_event(order_event_type::add, id, BuyLimit, p, sz,
+                          order_type::limit, sob->_order_event_parent);
     }
   
 
@@ -709,13 +720,24 @@ struct chain<typename sob_types::stop_chain_type, false>
     typedef chain<stop_chain_type, true> base_type;
     typedef stop_bndl bndl_type;
 
+    /* 'ev' is modify when a trailing stop is just being moved */
     static void
-    push(sob_class *sob, plevel p, stop_bndl&& bndl)
+    push( sob_class *sob,
+          plevel p,
+          stop_bndl&& bndl,
+          order_event_type ev = order_event_type::add )
     {        
         bool is_buy = bndl.is_buy;
+        id_type id = bndl.id;
+        size_t sz = bndl.sz;
+        order_type ot = order::as_order_type(bndl);
         base_type::push(sob,p->stops, std::move(bndl), p);
+        sob->_stop_size_change(p, is_buy, sz, true);
         is_buy ? exec::stop<true>::adjust_state_after_insert(sob, p)
                : exec::stop<false>::adjust_state_after_insert(sob, p);
+        sob->_order_event(ev, id, is_buy, p, sz, ot,
+                          (ev == order_event_type::add)
+                              ? sob->_order_event_parent : 0);
     }
 
     static stop_bndl
@@ -729,6 +751,7 @@ struct chain<typename sob_types::stop_chain_type, false>
         
         erase(p, iwrap.s_iter); // first
         sob->_id_cache.erase(id); // second 
+        sob->_stop_size_change(p, bndl.is_buy, bndl.sz, false);
      
         if( empty(p) ){
             bndl.is_buy ? exec::stop<true>::adjust_state_after_pull(sob, p)
@@ -936,11 +959,11 @@ struct depth<sob::side_of_market::both>  : public sob_types {
 
 
 template<>
-struct promise_helper< std::pair<id_type, sob_types::callback_queue_type> >
+struct promise_helper< std::pair<id_type, sob_types::callback_buffer_type> >
         : public sob_types {    
     template<typename A>    
-    static constexpr std::pair<id_type, A> 
-    build_value(id_type ret, const A& a) { return {ret, a}; }
+    static inline std::pair<id_type, A> 
+    build_value(id_type ret, A& a) { return {ret, std::move(a)}; }
     
     static constexpr order_exec_cb_bndl::type 
     callback_type = order_exec_cb_bndl::type::synchronous;
@@ -953,7 +976,7 @@ struct promise_helper<id_type>
         : public sob_types {
     template<typename A>     
     static constexpr id_type
-    build_value(id_type ret, const A& a) { return ret; }
+    build_value(id_type ret, A& a) { return ret; }
     
     static constexpr order_exec_cb_bndl::type 
     callback_type = order_exec_cb_bndl::type::asynchronous;
@@ -26,6 +26,7 @@ along with this program. If not, see http://www.gnu.org/licenses.
  *      src/orderbook/orders.cpp
  *      src/orderbook/impl.tpp
  *      src/orderbook/specials.tpp
+ *      src/worker_pool.cpp
  *
  *  Interfaces are declared in: 
  *
@@ -37,6 +38,83 @@ namespace sob{
 SOB_RESOURCE_MANAGER<FullInterface, SimpleOrderbook::ImplDeleter>
 SimpleOrderbook::master_rmanager("master");
 
+std::shared_ptr<WorkerPool> SimpleOrderbook::dispatcher_pool;
+std::shared_ptr<WorkerPool> SimpleOrderbook::callback_pool;
+std::mutex SimpleOrderbook::pools_mtx;
+std::atomic<bool> SimpleOrderbook::inline_execution(false);
+thread_local bool SimpleOrderbook::inline_execution_this_thread = false;
+
+
+void
+SimpleOrderbook::UseDispatcherPool(unsigned int nthreads)
+{
+    std::shared_ptr<WorkerPool> pool;
+    if( nthreads )
+        pool = std::make_shared<WorkerPool>(nthreads);
+
+    std::lock_guard<std::mutex> lock(pools_mtx);
+    dispatcher_pool.swap(pool);
+    // the old pool (if any) goes away w/ the last book created on it
+}
+
+
+unsigned int
+SimpleOrderbook::DispatcherPoolSize()
+{
+    std::lock_guard<std::mutex> lock(pools_mtx);
+    return dispatcher_pool ? dispatcher_pool->size() : 0;
+}
+
+
+std::shared_ptr<WorkerPool>
+SimpleOrderbook::dispatcher_pool_in_use()
+{
+    std::lock_guard<std::mutex> lock(pools_mtx);
+    return dispatcher_pool;
+}
+
+
+void
+SimpleOrderbook::UseCallbackPool(unsigned int nthreads)
+{
+    std::shared_ptr<WorkerPool> pool;
+    if( nthreads )
+        pool = std::make_shared<WorkerPool>(nthreads);
+
+    std::lock_guard<std::mutex> lock(pools_mtx);
+    callback_pool.swap(pool);
+}
+
+
+unsigned int
+SimpleOrderbook::CallbackPoolSize()
+{
+    std::lock_guard<std::mutex> lock(pools_mtx);
+    return callback_pool ? callback_pool->size() : 0;
+}
+
+
+std::shared_ptr<WorkerPool>
+SimpleOrderbook::callback_pool_in_use()
+{
+    std::lock_guard<std::mutex> lock(pools_mtx);
+    return callback_pool;
+}
+
+void
+SimpleOrderbook::UseInlineExecution(bool on, bool this_thread_only)
+{
+    if( this_thread_only )
+        inline_execution_this_thread = on;
+    else
+        inline_execution = on;
+}
+
+
+bool
+SimpleOrderbook::InlineExecution()
+{ return inline_execution_this_thread || inline_execution.load(); }
+
 SimpleOrderbook::ImplDeleter::ImplDeleter( std::string tag,
                                            std::string msg,
                                            std::ostream& out )
@@ -160,6 +238,52 @@ to_string(const side_of_trade& s)
     }
 }
 
+std::string
+to_string(const wait_strategy& ws)
+{
+    switch(ws){
+    case wait_strategy::blocking: return "blocking";
+    case wait_strategy::spin_yield: return "spin-yield";
+    case wait_strategy::busy_spin: return "busy-spin";
+    default: THROW_ENUM_TO_STR_EXC("wait_strategy", ws);
+    }
+}
+
+std::string
+to_string(const overflow_policy& op)
+{
+    switch(op){
+    case overflow_policy::block: return "block";
+    case overflow_policy::reject: return "reject";
+    case overflow_policy::shed: return "shed";
+    default: THROW_ENUM_TO_STR_EXC("overflow_policy", op);
+    }
+}
+
+std::string
+to_string(const order_event_type& et)
+{
+    switch(et){
+    case order_event_type::add: return "add";
+    case order_event_type::cancel: return "cancel";
+    case order_event_type::modify: return "modify";
+    case order_event_type::fill: return "fill";
+    case order_event_type::stop_trigger: return "stop-trigger";
+    default: THROW_ENUM_TO_STR_EXC("order_event_type", et);
+    }
+}
+
+std::string
+to_string(const sob_thread& t)
+{
+    switch(t){
+    case sob_thread::dispatcher: return "dispatcher";
+    case sob_thread::async_callback: return "async-callback";
+    case sob_thread::both: return "dispatcher/async-callback";
+    default: THROW_ENUM_TO_STR_EXC("sob_thread", t);
+    }
+}
+
 std::string
 to_string(const order_condition& oc)
 {
@@ -294,6 +418,22 @@ std::ostream&
 operator<<(std::ostream& out, const side_of_trade& s)
 { return (out << to_string(s)); }
 
+std::ostream&
+operator<<(std::ostream& out, const wait_strategy& ws)
+{ return (out << to_string(ws)); }
+
+std::ostream&
+operator<<(std::ostream& out, const sob_thread& t)
+{ return (out << to_string(t)); }
+
+std::ostream&
+operator<<(std::ostream& out, const overflow_policy& op)
+{ return (out << to_string(op)); }
+
+std::ostream&
+operator<<(std::ostream& out, const order_event_type& et)
+{ return (out << to_string(et)); }
+
 std::ostream&
 operator<<(std::ostream& out, const clock_type::time_point& tp)
 { return (out << to_string(tp)); }
@@ -321,6 +461,49 @@ std::ostream&
 operator<<(std::ostream& out, const timesale_entry_type& entry)
 { return (out << to_string(entry)); }
 
+top_of_book::top_of_book()
+    :
+        bid_price(0),
+        bid_size(0),
+        ask_price(0),
+        ask_size(0),
+        last_price(0),
+        last_size(0),
+        volume(0),
+        last_id(0),
+        window(0)
+    {
+    }
+
+depth_snapshot::depth_snapshot()
+    :
+        bids(),
+        asks(),
+        window(0)
+    {
+    }
+
+depth_delta::depth_delta()
+    :
+        seq(0),
+        side(side_of_market::bid),
+        price(0),
+        size(0)
+    {
+    }
+
+depth_delta::depth_delta( unsigned long long seq,
+                          side_of_market side,
+                          double price,
+                          size_t size )
+    :
+        seq(seq),
+        side(side),
+        price(price),
+        size(size)
+    {
+    }
+
 order_info::order_info()
     :
         type(sob::order_type::null),
@@ -348,6 +531,19 @@ order_info::order_info( order_type type,
     {
     }
 
+order_status::order_status()
+    :
+        id(0),
+        limit_tick(0),
+        stop_tick(0),
+        size(0),
+        type(sob::order_type::null),
+        is_buy(false),
+        condition(sob::order_condition::none),
+        trigger(sob::condition_trigger::none)
+    {
+    }
+
 order_info::order_info(const order_info& oi)
     :
         type(oi.type),
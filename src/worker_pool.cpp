@@ -0,0 +1,187 @@
+/*
+Copyright (C) 2017 Jonathon Ogden < jeog.dev@gmail.com >
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see http://www.gnu.org/licenses.
+*/
+
+#include <stdexcept>
+#include <iostream>
+
+#include "../include/worker_pool.hpp"
+
+namespace {
+
+using namespace sob;
+
+/* how many times an idle worker looks for work before it goes to sleep */
+constexpr unsigned int LOOKS_BEFORE_SLEEP = 64;
+
+/* which pool (and which of its workers) the current thread belongs to */
+thread_local const WorkerPool *this_pool = nullptr;
+thread_local size_t this_worker = 0;
+
+} /* namespace */
+
+
+namespace sob{
+
+WorkerPool::WorkerPool(unsigned int nthreads)
+    :
+        _workers(),
+        _queued(0),
+        _sleeping(0),
+        _next(0),
+        _sleep_mtx(),
+        _sleep_cond(),
+        _run_flag(true)
+    {
+        if( nthreads == 0 )
+            throw std::invalid_argument("WorkerPool needs at least one thread");
+
+        for( unsigned int i = 0; i < nthreads; ++i )
+            _workers.emplace_back( new worker() );
+
+        /* all the queues need to exist before anyone tries to steal */
+        for( size_t i = 0; i < _workers.size(); ++i )
+            _workers[i]->thread = std::thread( [=](){ _threaded_worker(i); } );
+    }
+
+
+WorkerPool::~WorkerPool()
+    {
+        _run_flag = false;
+        {
+            std::lock_guard<std::mutex> lock(_sleep_mtx);
+        }
+        _sleep_cond.notify_all();
+        for( auto& w : _workers ){
+            if( w->thread.joinable() )
+                w->thread.join();
+        }
+        if( _queued )
+            std::cerr<< "WorkerPool destroyed with " << _queued
+                     << " queued tasks" << std::endl;
+    }
+
+
+void
+WorkerPool::submit(Task *task)
+{
+    size_t index = in_worker()
+                 ? this_worker
+                 : _next.fetch_add(1, std::memory_order_relaxed) % _workers.size();
+    _push(index, task);
+}
+
+
+bool
+WorkerPool::in_worker() const
+{ return this_pool == this; }
+
+
+void
+WorkerPool::_threaded_worker(size_t index)
+{
+    this_pool = this;
+    this_worker = index;
+
+    for( unsigned int looks = 0; ; ){
+        Task *task = _pop(index);
+        if( !task )
+            task = _steal(index);
+
+        if( task ){
+            looks = 0;
+            try{
+                if( task->run() )
+                    _push(index, task);
+            }catch( std::exception& e ){
+                std::cerr<< "exception in WorkerPool task: " << e.what() << std::endl;
+            }
+            continue;
+        }
+
+        if( ++looks < LOOKS_BEFORE_SLEEP ){
+            std::this_thread::yield();
+            continue;
+        }
+        looks = 0;
+
+        std::unique_lock<std::mutex> lock(_sleep_mtx);
+        ++_sleeping;
+        _sleep_cond.wait(
+            lock,
+            [this]{ return _queued.load() || !_run_flag; }
+        );
+        --_sleeping;
+        if( !_run_flag && !_queued )
+            return;
+    }
+}
+
+
+WorkerPool::Task*
+WorkerPool::_pop(size_t index)
+{
+    worker& w = *_workers[index];
+    std::lock_guard<std::mutex> lock(w.mtx);
+    if( w.tasks.empty() )
+        return nullptr;
+
+    Task *task = w.tasks.front();
+    w.tasks.pop_front();
+    --_queued;
+    return task;
+}
+
+
+/* take from the back of someone else's queue, starting w/ our neighbor */
+WorkerPool::Task*
+WorkerPool::_steal(size_t index)
+{
+    size_t n = _workers.size();
+    for( size_t i = 1; i < n && _queued; ++i ){
+        worker& w = *_workers[(index + i) % n];
+        std::lock_guard<std::mutex> lock(w.mtx);
+        if( w.tasks.empty() )
+            continue;
+
+        Task *task = w.tasks.back();
+        w.tasks.pop_back();
+        --_queued;
+        return task;
+    }
+    return nullptr;
+}
+
+
+void
+WorkerPool::_push(size_t index, Task *task)
+{
+    worker& w = *_workers[index];
+    {
+        std::lock_guard<std::mutex> lock(w.mtx);
+        w.tasks.push_back(task);
+        ++_queued;
+    }
+    /* only pay for the wake-up if someone is (about to be) asleep */
+    if( _sleeping ){
+        {
+            std::lock_guard<std::mutex> lock(_sleep_mtx);
+        }
+        _sleep_cond.notify_one();
+    }
+}
+
+}; /* sob */
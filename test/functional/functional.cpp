@@ -48,13 +48,43 @@ orderbook_tests = {
       {"TEST_basic_orders_2", TEST_basic_orders_2},
       {"TEST_stop_orders_1", TEST_stop_orders_1},
       {"TEST_basic_orders_ASYNC_1", TEST_basic_orders_ASYNC_1},
+      {"TEST_insert_orders_1", TEST_insert_orders_1},
+      {"TEST_insert_orders_ASYNC_1", TEST_insert_orders_ASYNC_1},
       {"TEST_orders_info_pull_1", TEST_orders_info_pull_1},
       {"TEST_orders_info_pull_ASYNC_1", TEST_orders_info_pull_ASYNC_1},
       {"TEST_replace_order_1", TEST_replace_order_1},
       {"TEST_replace_order_ASYNC_1", TEST_replace_order_ASYNC_1},
+      {"TEST_client_ids_1", TEST_client_ids_1},
+      {"TEST_client_ids_ASYNC_1", TEST_client_ids_ASYNC_1},
+      {"TEST_pull_all_1", TEST_pull_all_1},
+      {"TEST_pull_all_ASYNC_1", TEST_pull_all_ASYNC_1},
+      {"TEST_modify_order_1", TEST_modify_order_1},
+      {"TEST_modify_order_2", TEST_modify_order_2},
+      {"TEST_modify_order_ASYNC_1", TEST_modify_order_ASYNC_1},
       {"TEST_grow_1", TEST_grow_1},
       {"TEST_grow_2", TEST_grow_2} ,
       {"TEST_grow_ASYNC_1", TEST_grow_ASYNC_1},
+      {"TEST_wait_strategy_1", TEST_wait_strategy_1},
+      {"TEST_async_callbacks_1", TEST_async_callbacks_1},
+      {"TEST_sync_callbacks_1", TEST_sync_callbacks_1},
+      {"TEST_top_of_book_1", TEST_top_of_book_1},
+      {"TEST_depth_snapshot_1", TEST_depth_snapshot_1},
+      {"TEST_dispatcher_pool_1", TEST_dispatcher_pool_1},
+      {"TEST_callback_pool_1", TEST_callback_pool_1},
+      {"TEST_cancel_lane_1", TEST_cancel_lane_1},
+      {"TEST_queue_capacity_1", TEST_queue_capacity_1},
+      {"TEST_replace_coalescing_1", TEST_replace_coalescing_1},
+      {"TEST_inline_execution_1", TEST_inline_execution_1},
+      {"TEST_clock_1", TEST_clock_1},
+      {"TEST_backtest_runner_1", TEST_backtest_runner_1},
+      {"TEST_depth_deltas_1", TEST_depth_deltas_1},
+      {"TEST_order_events_1", TEST_order_events_1},
+      {"TEST_depth_levels_1", TEST_depth_levels_1},
+      {"TEST_stop_depth_1", TEST_stop_depth_1},
+      {"TEST_bars_1", TEST_bars_1},
+      {"TEST_estimate_fill_1", TEST_estimate_fill_1},
+      {"TEST_order_status_1", TEST_order_status_1},
+      {"TEST_visit_1", TEST_visit_1},
       {"TEST_advanced_AON_1", TEST_advanced_AON_1},
       {"TEST_advanced_AON_2", TEST_advanced_AON_2},
       {"TEST_advanced_AON_3", TEST_advanced_AON_3},
@@ -45,16 +45,46 @@ DECL_TICK_TEST_FUNC(tick_price_1);
 DECL_SOB_TEST_FUNC(grow_1);
 DECL_SOB_TEST_FUNC(grow_2);
 DECL_SOB_TEST_FUNC(grow_ASYNC_1);
+DECL_SOB_TEST_FUNC(wait_strategy_1);
+DECL_SOB_TEST_FUNC(async_callbacks_1);
+DECL_SOB_TEST_FUNC(sync_callbacks_1);
+DECL_SOB_TEST_FUNC(top_of_book_1);
+DECL_SOB_TEST_FUNC(depth_snapshot_1);
+DECL_SOB_TEST_FUNC(dispatcher_pool_1);
+DECL_SOB_TEST_FUNC(callback_pool_1);
+DECL_SOB_TEST_FUNC(cancel_lane_1);
+DECL_SOB_TEST_FUNC(queue_capacity_1);
+DECL_SOB_TEST_FUNC(replace_coalescing_1);
+DECL_SOB_TEST_FUNC(inline_execution_1);
+DECL_SOB_TEST_FUNC(clock_1);
+DECL_SOB_TEST_FUNC(backtest_runner_1);
+DECL_SOB_TEST_FUNC(depth_deltas_1);
+DECL_SOB_TEST_FUNC(order_events_1);
+DECL_SOB_TEST_FUNC(depth_levels_1);
+DECL_SOB_TEST_FUNC(stop_depth_1);
+DECL_SOB_TEST_FUNC(bars_1);
+DECL_SOB_TEST_FUNC(estimate_fill_1);
+DECL_SOB_TEST_FUNC(order_status_1);
+DECL_SOB_TEST_FUNC(visit_1);
 /* basic_orders.cpp */
 DECL_SOB_TEST_FUNC(basic_orders_1);
 DECL_SOB_TEST_FUNC(basic_orders_2);
 DECL_SOB_TEST_FUNC(stop_orders_1);
 DECL_SOB_TEST_FUNC(basic_orders_ASYNC_1);
+DECL_SOB_TEST_FUNC(insert_orders_1);
+DECL_SOB_TEST_FUNC(insert_orders_ASYNC_1);
 /* pull_replace.cpp */
 DECL_SOB_TEST_FUNC(orders_info_pull_1);
 DECL_SOB_TEST_FUNC(orders_info_pull_ASYNC_1);
 DECL_SOB_TEST_FUNC(replace_order_1);
 DECL_SOB_TEST_FUNC(replace_order_ASYNC_1);
+DECL_SOB_TEST_FUNC(client_ids_1);
+DECL_SOB_TEST_FUNC(client_ids_ASYNC_1);
+DECL_SOB_TEST_FUNC(pull_all_1);
+DECL_SOB_TEST_FUNC(pull_all_ASYNC_1);
+DECL_SOB_TEST_FUNC(modify_order_1);
+DECL_SOB_TEST_FUNC(modify_order_2);
+DECL_SOB_TEST_FUNC(modify_order_ASYNC_1);
 /* advanced_orders/once_cancels_other.cpp */
 DECL_SOB_TEST_FUNC(advanced_OCO_1);
 DECL_SOB_TEST_FUNC(advanced_OCO_2);
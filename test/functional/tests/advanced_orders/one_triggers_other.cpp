@@ -32,7 +32,7 @@ namespace{
     size_t sz = 100;
 
     set<id_type> ids;
-    auto ecb = [&]( sob::callback_msg msg, sob::id_type id1, sob::id_type id2,
+    auto ecb = []( sob::callback_msg msg, sob::id_type id1, sob::id_type id2,
                     double price, size_t size)
         {
             if(msg == callback_msg::trigger_OTO ){
@@ -19,6 +19,8 @@ along with this program. If not, see http://www.gnu.org/licenses.
 
 #ifdef RUN_FUNCTIONAL_TESTS
 
+#include <atomic>
+
 using namespace sob;
 using namespace std;
 
@@ -353,4 +355,148 @@ TEST_basic_orders_ASYNC_1(FullInterface *orderbook, std::ostream& out)
     return 0;
 }
 
+
+namespace{
+
+/* ladder of buys + a few orders that should fail on their own */
+OrderBatch
+build_test_batch(FullInterface *orderbook, order_exec_cb_type cb)
+{
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+
+    OrderBatch batch(16);
+    for( int i = 1; i <= 10; ++i )
+        batch.add_limit_order(true, orderbook->price_to_tick(beg + i*incr), sz, cb);
+    batch.add_limit_order(true, orderbook->max_price() + 100 * incr, sz, cb); // 10
+    batch.add_limit_order(true, beg + incr, 0, cb); // 11
+    batch.add_stop_order(false, beg + incr, sz, cb,
+                         AdvancedOrderTicketAON::build()); // 12
+    batch.add_market_order(false, sz, cb); // 13
+    return batch;
+}
+
+template<typename E>
+bool
+failed_with(const batch_result& r)
+{
+    if( r || !r.error )
+        return false;
+    try{
+        std::rethrow_exception(r.error);
+    }catch( E& e ){
+        return true;
+    }catch( ... ){
+    }
+    return false;
+}
+
+int
+check_test_batch( FullInterface *orderbook,
+                  const vector<batch_result>& results,
+                  unsigned long long window_before,
+                  std::ostream& out )
+{
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+
+    if( results.size() != 14 )
+        return 1;
+
+    id_type last = 0;
+    for( int i = 0; i < 10; ++i ){
+        if( !results[i] || results[i].error || results[i].id <= last )
+            return 2;
+        last = results[i].id;
+    }
+
+    if( !failed_with<std::invalid_argument>(results[10]) // bad price
+        || !failed_with<std::invalid_argument>(results[11]) // bad size
+        || !failed_with<advanced_order_error>(results[12]) ) // AON stop
+    {
+        return 3;
+    }
+
+    if( !results[13] || results[13].id <= last )
+        return 4;
+
+    /* the market sell took the top rung */
+    if( orderbook->bid_price() != orderbook->price_to_tick(beg + 9*incr)
+        || orderbook->total_bid_size() != 9 * sz
+        || orderbook->volume() != sz )
+    {
+        return 5;
+    }
+
+    /* all of it in one window */
+    if( orderbook->get_top_of_book().window != window_before + 1 ){
+        out<< "windows: " << window_before << " -> "
+           << orderbook->get_top_of_book().window << endl;
+        return 6;
+    }
+
+    return 0;
+}
+
+}; /* namespace */
+
+
+int
+TEST_insert_orders_1(FullInterface *orderbook, std::ostream& out)
+{
+    size_t nfills = 0;
+    order_exec_cb_type cb =
+        [&](callback_msg msg, id_type id1, id_type id2, double price, size_t s)
+        {
+            if( msg == callback_msg::fill )
+                ++nfills;
+        };
+
+    if( !orderbook->insert_orders(OrderBatch()).empty() )
+        return 1;
+
+    OrderBatch batch = build_test_batch(orderbook, cb);
+    unsigned long long window = orderbook->get_top_of_book().window;
+    int err = check_test_batch(orderbook, orderbook->insert_orders(batch),
+                               window, out);
+    if( err )
+        return 10 + err;
+
+    /* both sides of the fill, run before insert_orders returned */
+    if( nfills != 2 )
+        return 2;
+
+    return 0;
+}
+
+
+int
+TEST_insert_orders_ASYNC_1(FullInterface *orderbook, std::ostream& out)
+{
+    std::atomic<size_t> nfills(0);
+    order_exec_cb_type cb =
+        [&](callback_msg msg, id_type id1, id_type id2, double price, size_t s)
+        {
+            if( msg == callback_msg::fill )
+                ++nfills;
+        };
+
+    if( !orderbook->insert_orders_async(OrderBatch()).get().empty() )
+        return 1;
+
+    OrderBatch batch = build_test_batch(orderbook, cb);
+    unsigned long long window = orderbook->get_top_of_book().window;
+    auto f = orderbook->insert_orders_async(batch);
+    batch.clear(); // it's been copied
+    int err = check_test_batch(orderbook, f.get(), window, out);
+    if( err )
+        return 10 + err;
+
+    orderbook->wait_for_async_callbacks();
+    if( nfills != 2 )
+        return 2;
+
+    return 0;
+}
+
 #endif /* RUN_FUNCTIONAL_TESTS */
@@ -20,19 +20,244 @@ along with this program. If not, see http://www.gnu.org/licenses.
 #ifdef RUN_FUNCTIONAL_TESTS
 
 #include <map>
+#include <set>
 #include <vector>
 #include <tuple>
 #include <random>
 #include <iostream>
 #include <stdexcept>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <future>
+#include <streambuf>
+#include <limits>
+#include <functional>
 
 #include "../../../include/tick_price.hpp"
+#include "../../../include/backtest_runner.hpp"
 
 using namespace sob;
 using namespace std;
 
 namespace {
     size_t sz = 100;
+
+    /*
+     * holds the book's master lock - which stalls the dispatcher - by
+     * blocking inside dump_limits until release() is called
+     */
+    class DispatcherStall {
+        struct gate_buf : public std::streambuf {
+            std::promise<void> entered;
+            std::promise<void> open;
+            bool first = true;
+            int overflow(int c){
+                if( first ){
+                    first = false;
+                    entered.set_value();
+                    open.get_future().wait();
+                }
+                return c;
+            }
+        };
+        gate_buf _buf;
+        std::ostream _out;
+        std::thread _t;
+    public:
+        DispatcherStall(FullInterface *orderbook)
+            : _buf(), _out(&_buf), _t()
+        {
+            std::future<void> entered = _buf.entered.get_future();
+            _t = std::thread( [=](){ orderbook->dump_limits(_out); } );
+            entered.wait();
+        }
+        void release(){
+            if( _t.joinable() ){
+                _buf.open.set_value();
+                _t.join();
+            }
+        }
+        ~DispatcherStall(){ release(); }
+    };
+
+    void
+    subscribe_feed(ManagementInterface *orderbook, DepthDeltaRing *ring)
+    { orderbook->subscribe_depth_deltas(ring); }
+
+    void
+    subscribe_feed(ManagementInterface *orderbook, OrderEventRing *ring)
+    { orderbook->subscribe_order_events(ring); }
+
+    /*
+     * two copies of some state rebuilt from one of the feeds: 'early'
+     * subscribes up front w/ a ring small enough to spill, 'late' joins half
+     * way thru the random flow (see step); apply_one folds one element into
+     * the state, matches_book compares the state against the book
+     */
+    template<typename T, typename State>
+    class FeedReplicas {
+    public:
+        struct replica {
+            FeedRing<T> ring;
+            State state;
+            explicit replica(size_t cap) : ring(cap), state() {}
+        };
+
+        replica early;
+        replica late;
+
+        FeedReplicas( ManagementInterface *orderbook,
+                      size_t early_cap,
+                      std::function<bool(State&, const T&)> apply_one,
+                      std::function<bool(const State&)> matches_book )
+            : early(early_cap),
+              late(1024),
+              _orderbook(orderbook),
+              _apply_one(apply_one),
+              _matches_book(matches_book)
+            {}
+
+        /* the same ring can't be subscribed twice */
+        bool
+        subscribe_early()
+        {
+            subscribe_feed(_orderbook, &early.ring);
+            try{
+                subscribe_feed(_orderbook, &early.ring);
+                return false;
+            }catch( std::invalid_argument& e ){
+            }
+            return true;
+        }
+
+        bool
+        apply(replica& r)
+        {
+            vector<T> elems;
+            r.ring.pop(elems);
+            for( const T& e : elems ){
+                if( !_apply_one(r.state, e) )
+                    return false;
+            }
+            return r.ring.empty();
+        }
+
+        bool
+        synced(replica& r)
+        { return apply(r) && _matches_book(r.state); }
+
+        /* let the small ring back up for a while between checks */
+        bool
+        step(int i)
+        {
+            if( i == 500 )
+                subscribe_feed(_orderbook, &late.ring);
+            return (i % 50) != 49 || synced(early);
+        }
+
+    private:
+        ManagementInterface *_orderbook;
+        std::function<bool(State&, const T&)> _apply_one;
+        std::function<bool(const State&)> _matches_book;
+    };
+
+    /* what random_flow does besides insert limits */
+    enum flow_action : unsigned {
+        flow_market = 1,
+        flow_pull = 1 << 1,
+        flow_replace = 1 << 2,
+        flow_modify = 1 << 3,
+        flow_stop = 1 << 4,
+        flow_stop_limit = 1 << 5
+    };
+
+    /*
+     * 'n' random orders of 1-5 lots between ticks 2 and 17 above the min,
+     * each one of 'actions' or a limit (limits get two shares); pulls,
+     * replaces and modifies pick from 'orders', which gets the ID of
+     * everything inserted (an in place modify adds nothing); on_step(i) runs
+     * after each, a non-zero return stops the flow and is returned
+     */
+    template<typename OnStep>
+    int
+    random_flow( FullInterface *orderbook,
+                 unsigned seed,
+                 int n,
+                 unsigned actions,
+                 vector<id_type>& orders,
+                 OnStep on_step )
+    {
+        double beg = orderbook->min_price();
+        double incr = orderbook->tick_size();
+        std::mt19937 gen(seed);
+        std::uniform_int_distribution<int> tick(2, 17);
+        auto price = [&](){
+            return orderbook->price_to_tick(beg + tick(gen) * incr);
+        };
+        auto pick = [&](){ return orders[gen() % orders.size()]; };
+
+        vector<unsigned> menu;
+        for( unsigned a = flow_market; a <= flow_stop_limit; a <<= 1 ){
+            if( actions & a )
+                menu.push_back(a);
+        }
+
+        for( int i = 0; i < n; ++i ){
+            bool buy = (gen() % 2) != 0;
+            double p = price();
+            size_t s = (gen() % 5 + 1) * sz;
+            size_t k = gen() % (menu.size() + 2);
+            id_type id = 0;
+            try{
+                switch( k < menu.size() ? menu[k] : 0 ){
+                case flow_market:
+                    orderbook->insert_market_order(buy, s);
+                    break;
+                case flow_pull:
+                    if( !orders.empty() )
+                        orderbook->pull_order(pick());
+                    break;
+                case flow_replace:
+                    if( !orders.empty() )
+                        id = orderbook->replace_with_limit_order(pick(), buy, p, s);
+                    break;
+                case flow_modify:
+                    if( !orders.empty() ){
+                        id_type old = pick();
+                        id = orderbook->modify_order(old, s);
+                        if( id == old )
+                            id = 0;
+                    }
+                    break;
+                case flow_stop:
+                    id = orderbook->insert_stop_order(buy, p, s);
+                    break;
+                case flow_stop_limit:
+                    id = orderbook->insert_stop_order(buy, p, price(), s);
+                    break;
+                default:
+                    id = orderbook->insert_limit_order(buy, p, s);
+                }
+            }catch( liquidity_exception& e ){
+            }
+            if( id )
+                orders.push_back(id);
+            int ret = on_step(i);
+            if( ret )
+                return ret;
+        }
+        return 0;
+    }
+
+    void
+    random_flow( FullInterface *orderbook,
+                 unsigned seed,
+                 int n,
+                 unsigned actions,
+                 vector<id_type>& orders )
+    { random_flow(orderbook, seed, n, actions, orders, [](int){ return 0; }); }
 }
 
 int
@@ -455,5 +680,1848 @@ TEST_grow_ASYNC_1(FullInterface *full_orderbook, std::ostream& out)
     return 0;
 }
 
-#endif /* RUN_FUNCTIONAL_TESTS */
 
+int
+TEST_wait_strategy_1(FullInterface *full_orderbook, std::ostream& out)
+{
+    ManagementInterface *orderbook =
+            dynamic_cast<ManagementInterface*>(full_orderbook);
+
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+
+    try{
+        orderbook->get_wait_strategy(sob_thread::both);
+        return 1;
+    }catch( std::invalid_argument& e ){
+        out<< "caught: " << e.what() << endl;
+    }
+
+    try{
+        orderbook->pin_thread(1 << 20);
+        return 2;
+    }catch( std::invalid_argument& e ){
+        out<< "caught: " << e.what() << endl;
+    }
+
+#ifdef __linux__
+    if( !orderbook->pin_thread(0) )
+        return 3;
+    if( !orderbook->name_thread("sob-test", sob_thread::dispatcher)
+        || !orderbook->name_thread("sob-test-cb", sob_thread::async_callback) )
+    {
+        return 4;
+    }
+#endif
+
+    std::atomic<size_t> ncb(0); // async and sync callbacks both count
+    order_exec_cb_type cb =
+        [&](callback_msg msg, id_type id1, id_type id2, double price, size_t s)
+        {
+            if( msg == callback_msg::fill )
+                ++ncb;
+        };
+
+    vector<pair<wait_strategy, wait_strategy>> strategies = {
+        {wait_strategy::busy_spin, wait_strategy::busy_spin},
+        {wait_strategy::spin_yield, wait_strategy::blocking},
+        {wait_strategy::blocking, wait_strategy::spin_yield},
+        {wait_strategy::blocking, wait_strategy::blocking}
+    };
+
+    size_t n = 0;
+    for( auto& p : strategies ){
+        orderbook->set_wait_strategy(p.first, sob_thread::dispatcher);
+        orderbook->set_wait_strategy(p.second, sob_thread::async_callback);
+        out<< "dispatcher: " << orderbook->get_wait_strategy()
+           << ", async callback: "
+           << orderbook->get_wait_strategy(sob_thread::async_callback) << endl;
+
+        if( orderbook->get_wait_strategy(sob_thread::dispatcher) != p.first
+            || orderbook->get_wait_strategy(sob_thread::async_callback)
+               != p.second )
+        {
+            return 5;
+        }
+
+        /* give the threads a chance to go back to waiting */
+        std::this_thread::sleep_for( std::chrono::milliseconds(10) );
+
+        for( int i = 0; i < 10; ++i ){
+            orderbook->insert_limit_order_async(true, beg + incr, sz, cb);
+            orderbook->insert_limit_order(false, beg + incr, sz, cb);
+            n += 2;
+        }
+        orderbook->wait_for_async_callbacks();
+        if( ncb != n ){
+            return 6;
+        }
+    }
+
+    if( orderbook->volume() != n / 2 * sz ){
+        return 7;
+    }
+
+    return 0;
+}
+
+
+int
+TEST_async_callbacks_1(FullInterface *orderbook, std::ostream& out)
+{
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+
+    /* one window sweeps enough orders to spill past the callback ring */
+    const size_t norders = 1500;
+
+    vector<id_type> limit_ids;
+    vector<id_type> filled_ids;
+    size_t nmarket = 0;
+    bool slow = true;
+
+    order_exec_cb_type limit_cb =
+        [&](callback_msg msg, id_type id1, id_type id2, double price, size_t s)
+        {
+            if( slow ){
+                /* let the dispatcher get ahead of us */
+                std::this_thread::sleep_for( std::chrono::milliseconds(5) );
+                slow = false;
+            }
+            if( msg == callback_msg::fill )
+                filled_ids.push_back(id1);
+        };
+
+    order_exec_cb_type market_cb =
+        [&](callback_msg msg, id_type id1, id_type id2, double price, size_t s)
+        {
+            if( msg == callback_msg::fill )
+                ++nmarket;
+        };
+
+    for( size_t i = 0; i < norders; ++i ){
+        double p = (i < norders / 2) ? beg : beg + incr;
+        limit_ids.push_back(
+            orderbook->insert_limit_order_async(false, p, 1, limit_cb).get()
+            );
+    }
+
+    orderbook->insert_market_order_async(true, norders, market_cb).get();
+    orderbook->wait_for_async_callbacks();
+
+    out<< "limit fills: " << filled_ids.size()
+       << ", market fills: " << nmarket << endl;
+
+    if( filled_ids.size() != norders ){
+        return 1;
+    }else if( nmarket != norders ){
+        return 2;
+    }else if( filled_ids != limit_ids ){ // in time priority
+        return 3;
+    }else if( orderbook->volume() != norders ){
+        return 4;
+    }
+
+    /* and the ring still works after the overflow has been drained */
+    filled_ids.clear();
+    id_type id = orderbook->insert_limit_order_async(true, beg, 1, limit_cb).get();
+    orderbook->insert_market_order_async(false, 1).get();
+    orderbook->wait_for_async_callbacks();
+    if( filled_ids.size() != 1 || filled_ids[0] != id ){
+        return 5;
+    }
+
+    return 0;
+}
+
+
+int
+TEST_sync_callbacks_1(FullInterface *orderbook, std::ostream& out)
+{
+    double beg = orderbook->min_price();
+
+    /* windows of varying size reuse the same (recycled) callback buffers */
+    vector<id_type> filled_ids;
+    order_exec_cb_type cb =
+        [&](callback_msg msg, id_type id1, id_type id2, double price, size_t s)
+        {
+            if( msg == callback_msg::fill )
+                filled_ids.push_back(id1);
+        };
+
+    for( size_t n : {1, 50, 3, 200, 0, 10, 200, 1} ){
+        vector<id_type> ids;
+        for( size_t i = 0; i < n; ++i ){
+            ids.push_back( orderbook->insert_limit_order(true, beg, 1, cb) );
+        }
+        if( !filled_ids.empty() ){
+            return 1;
+        }
+        id_type mid = 0;
+        if( n ){
+            mid = orderbook->insert_market_order(false, n, cb);
+        }
+        /* each fill calls back the limit and the market order */
+        if( filled_ids.size() != 2 * n ){
+            return 2;
+        }
+        vector<id_type> limit_fills;
+        for( id_type id : filled_ids ){
+            if( id != mid )
+                limit_fills.push_back(id);
+        }
+        if( limit_fills != ids ){ // in time priority
+            return 3;
+        }
+        out<< "window w/ " << filled_ids.size() << " callbacks" << endl;
+        filled_ids.clear();
+    }
+
+    return 0;
+}
+
+
+int
+TEST_top_of_book_1(FullInterface *orderbook, std::ostream& out)
+{
+    auto conv = [&](double d){ return orderbook->price_to_tick(d); };
+
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+
+    top_of_book tob = orderbook->get_top_of_book();
+    if( tob.bid_size || tob.ask_size || tob.volume || tob.window ){
+        return 1;
+    }
+
+    /* readers don't block the dispatcher and always see a whole window */
+    std::atomic<bool> done(false);
+    std::atomic<int> reader_err(0);
+    std::thread reader([&]{
+        unsigned long long window = 0;
+        while( !done ){
+            top_of_book t = orderbook->get_top_of_book();
+            if( t.window < window ){
+                reader_err = 1;
+            }else if( t.bid_price && t.ask_price && t.bid_price >= t.ask_price ){
+                reader_err = 2;
+            }else if( (t.bid_price == 0) != (t.bid_size == 0) ){
+                reader_err = 3;
+            }
+            window = t.window;
+        }
+    });
+
+    size_t n = 200;
+    for( size_t i = 0; i < n; ++i ){
+        orderbook->insert_limit_order(true, beg, sz);
+        orderbook->insert_limit_order(false, conv(beg + 2*incr), sz);
+        if( i % 2 )
+            orderbook->insert_market_order(i % 4 == 1, sz);
+    }
+
+    done = true;
+    reader.join();
+    if( reader_err ){
+        return 10 + reader_err;
+    }
+
+    tob = orderbook->get_top_of_book();
+    out<< "window: " << tob.window << " bid: " << tob.bid_price << " "
+       << tob.bid_size << " ask: " << tob.ask_price << " " << tob.ask_size
+       << " last: " << tob.last_price << " " << tob.last_size
+       << " volume: " << tob.volume << endl;
+
+    if( tob.window != n * 2 + n / 2 ){
+        return 2;
+    }else if( tob.bid_price != orderbook->bid_price()
+              || tob.bid_size != orderbook->bid_size()
+              || tob.ask_price != orderbook->ask_price()
+              || tob.ask_size != orderbook->ask_size() )
+    {
+        return 3;
+    }else if( tob.last_price != orderbook->last_price()
+              || tob.last_size != orderbook->last_size()
+              || tob.volume != orderbook->volume()
+              || tob.last_id != orderbook->last_id() )
+    {
+        return 4;
+    }else if( tob.bid_size != (n - n / 4) * sz
+              || tob.ask_size != (n - n / 4) * sz ){
+        return 5;
+    }else if( tob.volume != n / 2 * sz ){
+        return 6;
+    }
+
+    return 0;
+}
+
+
+int
+TEST_depth_snapshot_1(FullInterface *full_orderbook, std::ostream& out)
+{
+    ManagementInterface *orderbook =
+            dynamic_cast<ManagementInterface*>(full_orderbook);
+
+    auto conv = [&](double d){ return orderbook->price_to_tick(d); };
+
+    double beg = orderbook->min_price();
+    double end = orderbook->max_price();
+    double incr = orderbook->tick_size();
+
+    auto dump = [&](const depth_snapshot& ds){
+        out<< "window " << ds.window << " :: ";
+        for( auto& l : ds.bids )
+            out<< l.first << "/" << l.second << " ";
+        out<< "|| ";
+        for( auto& l : ds.asks )
+            out<< l.first << "/" << l.second << " ";
+        out<< endl;
+    };
+
+    orderbook->insert_limit_order(true, beg, sz);
+    depth_snapshot ds = orderbook->get_depth_snapshot();
+    if( orderbook->get_depth_snapshot_levels() != 0
+        || !ds.bids.empty() || !ds.asks.empty() )
+    {
+        return 1;
+    }
+
+    orderbook->set_depth_snapshot_levels(3);
+    ds = orderbook->get_depth_snapshot();
+    dump(ds);
+    if( ds.bids.size() != 1 || ds.bids[0] != make_pair(beg, sz) ){
+        return 2;
+    }
+
+    for( int i = 1; i <= 4; ++i ){
+        orderbook->insert_limit_order(true, conv(beg + i*incr), sz * i);
+        orderbook->insert_limit_order(false, conv(end - i*incr), sz * i);
+    }
+    ds = orderbook->get_depth_snapshot();
+    dump(ds);
+    if( ds.window != orderbook->get_top_of_book().window ){
+        return 3;
+    }else if( ds.bids.size() != 3 || ds.asks.size() != 3 ){
+        return 4;
+    }
+    for( int i = 0; i < 3; ++i ){
+        if( ds.bids[i] != make_pair(conv(beg + (4-i)*incr), sz * (4-i)) )
+            return 5;
+        if( ds.asks[i] != make_pair(conv(end - (4-i)*incr), sz * (4-i)) )
+            return 6;
+    }
+
+    /* a window that doesn't change the top-N doesn't republish */
+    unsigned long long w = ds.window;
+    orderbook->insert_stop_order(true, end, sz);
+    orderbook->insert_limit_order(true, beg, sz);
+    ds = orderbook->get_depth_snapshot();
+    if( ds.window != w ){
+        return 7;
+    }
+
+    /* readers see complete snapshots while the book changes */
+    std::atomic<bool> done(false);
+    std::atomic<int> reader_err(0);
+    std::thread reader([&]{
+        while( !done ){
+            depth_snapshot d = orderbook->get_depth_snapshot();
+            if( d.bids.size() > 3 || d.asks.size() > 3 ){
+                reader_err = 1;
+            }
+            for( size_t i = 1; i < d.bids.size(); ++i ){
+                if( d.bids[i].first >= d.bids[i-1].first )
+                    reader_err = 2;
+            }
+            for( size_t i = 1; i < d.asks.size(); ++i ){
+                if( d.asks[i].first <= d.asks[i-1].first )
+                    reader_err = 3;
+            }
+        }
+    });
+
+    /* take from the inside, put it back */
+    for( int i = 0; i < 200; ++i ){
+        bool buy = i % 2;
+        orderbook->insert_market_order(buy, sz);
+        orderbook->insert_limit_order(!buy, buy ? conv(end - 4*incr)
+                                                : conv(beg + 4*incr), sz);
+    }
+
+    done = true;
+    reader.join();
+    if( reader_err ){
+        return 10 + reader_err;
+    }
+
+    ds = orderbook->get_depth_snapshot();
+    dump(ds);
+    auto md = orderbook->bid_depth(orderbook->ticks_in_range());
+    auto b = ds.bids.cbegin();
+    for( auto m = md.crbegin(); m != md.crend() && b != ds.bids.cend(); ++m ){
+        if( m->second == 0 )
+            continue;
+        if( b->first != m->first || (b++)->second != m->second )
+            return 8;
+    }
+
+    return 0;
+}
+
+
+int
+TEST_dispatcher_pool_1(FullInterface *full_orderbook, std::ostream& out)
+{
+    constexpr size_t NBOOKS = 16;
+    constexpr int NTHREADS = 4;
+    constexpr int NORDERS = 50;
+
+    auto proxy = SimpleOrderbook::BuildFactoryProxy<std::ratio<1,4>>();
+
+    SimpleOrderbook::UseDispatcherPool(2);
+    if( SimpleOrderbook::DispatcherPoolSize() != 2 )
+        return 1;
+
+    vector<FullInterface*> books;
+    for( size_t i = 0; i < NBOOKS; ++i )
+        books.push_back( proxy.create(1, 100) );
+
+    /* only books created while the pool is set use it */
+    SimpleOrderbook::UseDispatcherPool(0);
+    if( SimpleOrderbook::DispatcherPoolSize() != 0 )
+        return 2;
+
+    for( auto ob : books ){
+        /* the pool's workers aren't the book's to pin */
+        if( dynamic_cast<ManagementInterface*>(ob)->pin_thread(0, sob_thread::dispatcher) )
+            return 3;
+    }
+
+    std::atomic<size_t> ncb(0);
+    order_exec_cb_type cb =
+        [&](callback_msg msg, id_type id1, id_type id2, double price, size_t s)
+        {
+            if( msg == callback_msg::fill )
+                ++ncb;
+        };
+
+    /* every thread trades against every book; ids from one thread's
+       futures have to come back in the order the orders were pushed */
+    std::atomic<int> failed(0);
+    vector<std::thread> threads;
+    for( int t = 0; t < NTHREADS; ++t ){
+        threads.emplace_back(
+            [&, t](){
+                try{
+                    for( auto ob : books ){
+                        vector<std::future<id_type>> futs;
+                        for( int i = 0; i < NORDERS; ++i ){
+                            futs.push_back(
+                                ob->insert_limit_order_async(t % 2, 50, sz, cb)
+                            );
+                        }
+                        id_type last = 0;
+                        for( auto& f : futs ){
+                            id_type id = f.get();
+                            if( id <= last )
+                                failed = 1;
+                            last = id;
+                        }
+                        ob->insert_limit_order(t % 2, 50, sz, cb);
+                    }
+                }catch( std::exception& e ){
+                    failed = 2;
+                }
+            }
+        );
+    }
+    for( auto& t : threads )
+        t.join();
+
+    if( failed ){
+        out<< "failed: " << failed << endl;
+        return 4;
+    }
+
+    /* half the threads buy, half sell, at the same price */
+    size_t per_book = NTHREADS * (NORDERS + 1) * sz / 2;
+    for( auto ob : books ){
+        dynamic_cast<ManagementInterface*>(ob)->wait_for_async_callbacks();
+        if( ob->volume() != per_book ){
+            out<< "bad volume: " << ob->volume() << endl;
+            return 5;
+        }
+        if( ob->bid_size() || ob->ask_size() )
+            return 6;
+    }
+    if( ncb != NBOOKS * per_book / sz * 2 ){
+        out<< "bad callback count: " << ncb << endl;
+        return 7;
+    }
+
+    /* orders still queued when a book is destroyed are either
+       executed or dropped (broken promise), never left hanging */
+    vector<std::future<id_type>> futs;
+    for( auto ob : books ){
+        for( int i = 0; i < NORDERS; ++i )
+            futs.push_back( ob->insert_limit_order_async(true, 10, sz) );
+        proxy.destroy(ob);
+    }
+    size_t ndropped = 0;
+    for( auto& f : futs ){
+        try{
+            if( !f.get() )
+                return 8;
+        }catch( std::future_error& e ){
+            ++ndropped;
+        }
+    }
+    out<< "dropped " << ndropped << " of " << futs.size() << endl;
+
+    return 0;
+}
+
+
+int
+TEST_callback_pool_1(FullInterface *full_orderbook, std::ostream& out)
+{
+    constexpr size_t NBOOKS = 8;
+    constexpr int NORDERS = 300; // some books spill past the callback ring
+
+    auto proxy = SimpleOrderbook::BuildFactoryProxy<std::ratio<1,4>>();
+
+    /* w/ and w/o a dispatcher pool */
+    SimpleOrderbook::UseCallbackPool(2);
+    if( SimpleOrderbook::CallbackPoolSize() != 2 )
+        return 1;
+    vector<FullInterface*> books;
+    for( size_t i = 0; i < NBOOKS / 2; ++i )
+        books.push_back( proxy.create(1, 100) );
+    SimpleOrderbook::UseDispatcherPool(2);
+    for( size_t i = NBOOKS / 2; i < NBOOKS; ++i )
+        books.push_back( proxy.create(1, 100) );
+    SimpleOrderbook::UseDispatcherPool(0);
+    SimpleOrderbook::UseCallbackPool(0);
+    if( SimpleOrderbook::CallbackPoolSize() != 0 )
+        return 2;
+
+    for( auto ob : books ){
+        if( dynamic_cast<ManagementInterface*>(ob)->pin_thread(0, sob_thread::async_callback) )
+            return 3;
+    }
+
+    /* each buy takes one resting sell; its fill callbacks have to show up
+       in the order the buys were executed */
+    vector<vector<id_type>> fills(NBOOKS);
+    vector<vector<id_type>> ids(NBOOKS);
+    for( size_t b = 0; b < NBOOKS; ++b ){
+        FullInterface *ob = books[b];
+        vector<id_type> *f = &fills[b];
+        order_exec_cb_type cb =
+            [=](callback_msg msg, id_type id1, id_type id2, double price, size_t s)
+            {
+                if( msg == callback_msg::fill )
+                    f->push_back(id1);
+            };
+        for( int i = 0; i < NORDERS; ++i )
+            ob->insert_limit_order(false, 50, sz);
+        /* odd books sweep these in one window to force the overflow queue */
+        if( b % 2 ){
+            for( int i = 0; i < 1100; ++i )
+                ob->insert_limit_order(false, 51, sz);
+        }
+        vector<std::future<id_type>> futs;
+        for( int i = 0; i < NORDERS; ++i )
+            futs.push_back( ob->insert_limit_order_async(true, 50, sz, cb) );
+        for( auto& fut : futs )
+            ids[b].push_back( fut.get() );
+        if( b % 2 ){
+            id_type id = ob->insert_market_order_async(true, sz * 1100, cb).get();
+            ids[b].insert(ids[b].end(), 1100, id);
+        }
+    }
+
+    for( size_t b = 0; b < NBOOKS; ++b ){
+        dynamic_cast<ManagementInterface*>(books[b])->wait_for_async_callbacks();
+        if( fills[b].size() != ids[b].size()
+            || !std::equal(ids[b].begin(), ids[b].end(), fills[b].begin()) )
+        {
+            out<< "bad callback order for book " << b << endl;
+            return 4;
+        }
+    }
+
+    for( auto ob : books )
+        proxy.destroy(ob);
+
+    return 0;
+}
+
+
+int
+TEST_cancel_lane_1(FullInterface *full_orderbook, std::ostream& out)
+{
+    ManagementInterface *orderbook =
+            dynamic_cast<ManagementInterface*>(full_orderbook);
+
+    double beg = orderbook->min_price();
+    size_t n = 1000;
+
+    orderbook->reset_queue_time_stats();
+
+    vector<id_type> ids;
+    for( size_t i = 0; i < 10; ++i ){
+        ids.push_back( orderbook->insert_limit_order(true, beg, 1) );
+    }
+    orderbook->insert_limit_order(true, beg, 1, nullptr,
+                                  AdvancedOrderTicket::null, make_client_id(1));
+
+    /* flood of inserts w/ pulls of the live orders pushed behind them */
+    vector<future<id_type>> inserts;
+    for( size_t i = 0; i < n; ++i ){
+        inserts.push_back( orderbook->insert_limit_order_async(true, beg, 1) );
+    }
+    vector<future<id_type>> pulls;
+    for( id_type id : ids ){
+        pulls.push_back( orderbook->pull_order_async(id) );
+    }
+    /* pulls by client id stay in line */
+    pulls.push_back( orderbook->pull_order_async(make_client_id(1)) );
+
+    for( auto& f : pulls ){
+        if( !f.get() )
+            return 1;
+    }
+    for( auto& f : inserts ){
+        if( !f.get() )
+            return 2;
+    }
+    if( orderbook->total_bid_size() != n ){
+        return 3;
+    }
+
+    queue_time_stats cancels = orderbook->get_cancel_queue_time_stats();
+    queue_time_stats orders = orderbook->get_order_queue_time_stats();
+    out<< "cancels: " << cancels.count << " mean(ns) "
+       << chrono::duration_cast<chrono::nanoseconds>(cancels.mean()).count()
+       << endl;
+    out<< "orders: " << orders.count << " mean(ns) "
+       << chrono::duration_cast<chrono::nanoseconds>(orders.mean()).count()
+       << endl;
+
+    if( cancels.count != ids.size() || orders.count != n + ids.size() + 2 ){
+        return 4;
+    }
+    if( cancels.max < cancels.mean() || orders.max < orders.mean() ){
+        return 5;
+    }
+
+    orderbook->reset_queue_time_stats();
+    if( orderbook->get_cancel_queue_time_stats().count
+        || orderbook->get_order_queue_time_stats().count ){
+        return 6;
+    }
+
+    return 0;
+}
+
+
+int
+TEST_queue_capacity_1(FullInterface *full_orderbook, std::ostream& out)
+{
+    ManagementInterface *orderbook =
+            dynamic_cast<ManagementInterface*>(full_orderbook);
+
+    double beg = orderbook->min_price();
+    size_t cap = 4;
+
+    id_type resting = orderbook->insert_limit_order(true, beg, 1);
+    orderbook->set_queue_capacity(cap, overflow_policy::reject);
+    if( orderbook->get_queue_capacity() != cap
+        || orderbook->get_overflow_policy() != overflow_policy::reject ){
+        return 1;
+    }
+
+    DispatcherStall stall(orderbook);
+
+    /* wait for the dispatcher to take the first one and get stuck */
+    vector<future<id_type>> futs;
+    futs.push_back( orderbook->insert_limit_order_async(true, beg, 1) );
+    while( orderbook->get_queue_depth() ){
+        this_thread::sleep_for( chrono::milliseconds(1) );
+    }
+
+    for( size_t i = 0; i < cap; ++i ){
+        futs.push_back( orderbook->insert_limit_order_async(true, beg, 1) );
+    }
+    if( orderbook->get_queue_depth() != cap ){
+        return 2;
+    }
+
+    /* reject */
+    try{
+        orderbook->insert_limit_order_async(true, beg, 1);
+        return 3;
+    }catch( queue_full_error& e ){
+        out<< "caught: " << e.what() << endl;
+    }
+
+    /* shed: pulls get in by dropping the newest insert, inserts don't */
+    orderbook->set_queue_capacity(cap, overflow_policy::shed);
+    future<id_type> pull = orderbook->pull_order_async(resting);
+    try{
+        orderbook->insert_limit_order_async(true, beg, 1);
+        return 4;
+    }catch( queue_full_error& e ){
+        out<< "caught: " << e.what() << endl;
+    }
+    if( orderbook->get_queue_depth() != cap
+        || orderbook->get_queue_rejections() != 3 ){
+        return 5;
+    }
+
+    /* block; switching to reject turns away anyone still waiting */
+    orderbook->set_queue_capacity(cap, overflow_policy::block);
+    future<id_type> rejected = async( launch::async, [=](){
+        return orderbook->insert_limit_order(true, beg, 1);
+    });
+    if( rejected.wait_for(chrono::milliseconds(50)) != future_status::timeout ){
+        return 12;
+    }
+    orderbook->set_queue_capacity(cap, overflow_policy::reject);
+    try{
+        rejected.get();
+        return 13;
+    }catch( queue_full_error& e ){
+        out<< "caught(unblocked): " << e.what() << endl;
+    }
+
+    orderbook->set_queue_capacity(cap, overflow_policy::block);
+    future<id_type> blocked = async( launch::async, [=](){
+        return orderbook->insert_limit_order(true, beg, 1);
+    });
+    if( blocked.wait_for(chrono::milliseconds(50)) != future_status::timeout ){
+        return 6;
+    }
+
+    stall.release();
+
+    if( !blocked.get() || !pull.get() ){
+        return 7;
+    }
+    for( size_t i = 0; i < futs.size(); ++i ){
+        try{
+            if( !futs[i].get() )
+                return 8;
+            if( i == cap )
+                return 9;
+        }catch( queue_full_error& e ){
+            if( i != cap )
+                return 10;
+            out<< "caught(shed): " << e.what() << endl;
+        }
+    }
+    if( orderbook->get_queue_depth() || orderbook->total_bid_size() != cap + 1 ){
+        return 11;
+    }
+
+    orderbook->set_queue_capacity(0);
+    return 0;
+}
+
+
+int
+TEST_replace_coalescing_1(FullInterface *full_orderbook, std::ostream& out)
+{
+    ManagementInterface *orderbook =
+            dynamic_cast<ManagementInterface*>(full_orderbook);
+
+    double beg = orderbook->min_price();
+    auto is_ready = [](future<id_type>& f){
+        return f.wait_for(chrono::seconds(0)) == future_status::ready;
+    };
+
+    orderbook->set_replace_coalescing(true);
+    if( !orderbook->get_replace_coalescing() ){
+        return 1;
+    }
+
+    id_type id1 = orderbook->insert_limit_order(true, beg, 1);
+    id_type id2 = orderbook->insert_limit_order(true, beg, 1);
+
+    DispatcherStall stall(orderbook);
+
+    future<id_type> f0 = orderbook->insert_limit_order_async(true, beg, 1);
+    while( orderbook->get_queue_depth() ){
+        this_thread::sleep_for( chrono::milliseconds(1) );
+    }
+
+    /* replace storm: only the last one should be left */
+    future<id_type> r1 = orderbook->replace_with_limit_order_async(id1, true, beg, 2);
+    future<id_type> r2 = orderbook->replace_with_limit_order_async(id1, true, beg, 3);
+    future<id_type> r3 = orderbook->replace_with_limit_order_async(id1, true, beg, 4);
+    if( !is_ready(r1) || r1.get() != superseded_id
+        || !is_ready(r2) || r2.get() != superseded_id
+        || is_ready(r3) || orderbook->get_queue_depth() != 1 ){
+        return 2;
+    }
+
+    /* a pull supersedes too */
+    future<id_type> r4 = orderbook->replace_with_limit_order_async(id2, true, beg, 5);
+    future<id_type> p2 = orderbook->pull_order_async(id2);
+    if( !is_ready(r4) || r4.get() != superseded_id
+        || orderbook->get_queue_depth() != 2 ){
+        return 3;
+    }
+
+    stall.release();
+
+    id_type id3 = r3.get();
+    if( !f0.get() || !id3 || id3 == superseded_id || p2.get() != 1 ){
+        return 4;
+    }
+    /* f0, and id1 replaced once (w/ 4) */
+    if( orderbook->total_bid_size() != 5
+        || orderbook->get_order_info(id3).size != 4 ){
+        return 5;
+    }
+    out<< "replaced: " << id1 << " -> " << id3 << endl;
+
+    orderbook->set_replace_coalescing(false);
+    return 0;
+}
+
+
+int
+TEST_inline_execution_1(FullInterface *full_orderbook, std::ostream& out)
+{
+    using cb_record = tuple<callback_msg, id_type, id_type, double, size_t>;
+
+    auto proxy = SimpleOrderbook::BuildFactoryProxy<std::ratio<1,4>>();
+    FullInterface *threaded = proxy.create(1, 100);
+    SimpleOrderbook::UseInlineExecution(true);
+    FullInterface *inlined = proxy.create(1, 100);
+    SimpleOrderbook::UseInlineExecution(false);
+
+    ManagementInterface *mi = dynamic_cast<ManagementInterface*>(inlined);
+    if( !mi->is_inline()
+        || dynamic_cast<ManagementInterface*>(threaded)->is_inline()
+        || mi->pin_thread(0, sob_thread::dispatcher)
+        || mi->name_thread("sob-inline", sob_thread::async_callback) ){
+        proxy.destroy(threaded);
+        proxy.destroy(inlined);
+        return 1;
+    }
+
+    /* the same (pseudo-random) flow through both books */
+    auto run = [&](FullInterface *ob, vector<cb_record>& cbs, vector<id_type>& ids){
+        order_exec_cb_type cb =
+            [&](callback_msg msg, id_type id1, id_type id2, double price, size_t s)
+            { cbs.emplace_back(msg, id1, id2, price, s); };
+        std::mt19937 gen(11);
+        std::uniform_int_distribution<int> tick(160, 240);
+        std::uniform_int_distribution<int> what(0, 9);
+        vector<id_type> orders;
+        for( int i = 0; i < 2000; ++i ){
+            bool buy = (gen() % 2) != 0;
+            double p = tick(gen) / 4.0;
+            size_t s = (gen() % 10 + 1) * sz;
+            id_type id = 0;
+            int w = what(gen);
+            try{
+            switch( w ){
+            case 0:
+                id = ob->insert_market_order(buy, s, cb);
+                break;
+            case 1:
+                id = ob->insert_stop_order(buy, p, s, cb);
+                break;
+            case 2:
+                id = ob->insert_stop_order(buy, p, p, s, cb);
+                break;
+            case 3:
+                id = orders.empty() ? 0
+                   : ob->pull_order(orders[gen() % orders.size()]);
+                break;
+            case 4:
+                id = orders.empty() ? 0
+                   : ob->replace_with_limit_order(orders[gen() % orders.size()],
+                                                  buy, p, s, cb);
+                if( id )
+                    orders.push_back(id);
+                break;
+            default:
+                id = ob->insert_limit_order(buy, p, s, cb);
+            }
+            }catch( liquidity_exception& e ){ // same for both books
+                id = superseded_id;
+            }
+            if( w != 3 && w != 4 && id != superseded_id )
+                orders.push_back(id);
+            ids.push_back(id);
+        }
+        ids.push_back( ob->insert_limit_order_async(true, 45, sz, cb).get() );
+    };
+
+    vector<cb_record> cbs_threaded, cbs_inline;
+    vector<id_type> ids_threaded, ids_inline;
+    run(threaded, cbs_threaded, ids_threaded);
+    run(inlined, cbs_inline, ids_inline);
+    dynamic_cast<ManagementInterface*>(threaded)->wait_for_async_callbacks();
+
+    int ret = 0;
+    if( ids_threaded != ids_inline || cbs_threaded != cbs_inline ){
+        ret = 2;
+    }else if( threaded->bid_price() != inlined->bid_price()
+              || threaded->ask_price() != inlined->ask_price()
+              || threaded->volume() != inlined->volume()
+              || threaded->total_bid_size() != inlined->total_bid_size()
+              || threaded->total_ask_size() != inlined->total_ask_size() ){
+        ret = 3;
+    }
+    out<< "ids: " << ids_inline.size() << " callbacks: " << cbs_inline.size()
+       << " volume: " << inlined->volume() << endl;
+
+    /* collected instead of run; async returns a ready future */
+    proxy.destroy(inlined);
+    SimpleOrderbook::UseInlineExecution(true);
+    inlined = proxy.create(1, 100);
+    SimpleOrderbook::UseInlineExecution(false);
+    mi = dynamic_cast<ManagementInterface*>(inlined);
+    if( !ret ){
+        size_t nrun = 0;
+        order_exec_cb_type cb =
+            [&](callback_msg msg, id_type id1, id_type id2, double price, size_t s)
+            { ++nrun; };
+        vector<callback_event> buf;
+        mi->set_inline_callback_buffer(&buf);
+        id_type id1 = inlined->insert_limit_order(false, 99, sz, cb);
+        future<id_type> f = inlined->insert_market_order_async(true, sz, cb);
+        if( f.wait_for(chrono::seconds(0)) != future_status::ready || !f.get()
+            || nrun || buf.size() != 2 || buf[1].id1 != id1
+            || buf[1].msg != callback_msg::fill ){
+            ret = 4;
+        }else{
+            for( auto& e : buf )
+                e();
+            if( nrun != 2 )
+                ret = 5;
+        }
+        mi->set_inline_callback_buffer(nullptr);
+    }
+
+    try{
+        dynamic_cast<ManagementInterface*>(threaded)->set_inline_callback_buffer(nullptr);
+        ret = ret ? ret : 6;
+    }catch( std::logic_error& e ){
+    }
+
+    proxy.destroy(threaded);
+    proxy.destroy(inlined);
+    return ret;
+}
+
+
+int
+TEST_clock_1(FullInterface *full_orderbook, std::ostream& out)
+{
+    ManagementInterface *orderbook =
+            dynamic_cast<ManagementInterface*>(full_orderbook);
+
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+    clock_type::time_point t0 = clock_type::time_point() + chrono::hours(1);
+    clock_type::duration step = chrono::seconds(1);
+
+    auto sweep = [&](){
+        for( int i = 0; i < 3; ++i )
+            orderbook->insert_limit_order(false, beg + incr * (i + 1), sz);
+        orderbook->insert_market_order(true, sz * 3);
+    };
+    auto last_times = [&](size_t n){
+        const vector<timesale_entry_type>& ts = orderbook->time_and_sales();
+        vector<clock_type::time_point> tps;
+        for( size_t i = ts.size() - n; i < ts.size(); ++i )
+            tps.push_back( get<0>(ts[i]) );
+        return tps;
+    };
+
+    /* externally set */
+    orderbook->set_time(t0);
+    sweep();
+    for( auto& tp : last_times(3) ){
+        if( tp != t0 )
+            return 1;
+    }
+
+    /* simulated, read per trade */
+    orderbook->set_clock( simulated_clock(t0, step) );
+    sweep();
+    vector<clock_type::time_point> tps = last_times(3);
+    if( tps[0] != t0 || tps[1] != t0 + step || tps[2] != t0 + step * 2 )
+        return 2;
+
+    /* simulated, read once per window */
+    orderbook->set_timestamp_per_window(true);
+    if( !orderbook->get_timestamp_per_window() )
+        return 3;
+    sweep();
+    tps = last_times(3);
+    if( tps[0] != t0 + step * 3 || tps[1] != tps[0] || tps[2] != tps[0] )
+        return 4;
+    sweep();
+    if( last_times(1)[0] != t0 + step * 4 )
+        return 5;
+    out<< "window time: " << last_times(1)[0] << endl;
+
+    orderbook->set_timestamp_per_window(false);
+    orderbook->set_clock(nullptr);
+    clock_type::time_point before = clock_type::now();
+    sweep();
+    if( last_times(1)[0] < before )
+        return 6;
+
+    return 0;
+}
+
+
+int
+TEST_backtest_runner_1(FullInterface *full_orderbook, std::ostream& out)
+{
+    constexpr int NJOBS = 24;
+    constexpr int BAD_JOB = 5;
+
+    auto proxy = SimpleOrderbook::BuildFactoryProxy<std::ratio<1,4>>();
+
+    /* job i: an order stream seeded w/ i, of a length that varies w/ i */
+    auto stream = [](int i){
+        return [=](FullInterface *ob){
+            if( !dynamic_cast<ManagementInterface*>(ob)->is_inline() )
+                throw std::runtime_error("book isn't inline");
+            if( i == BAD_JOB )
+                throw std::invalid_argument("bad job");
+            std::mt19937 gen(i);
+            std::uniform_int_distribution<int> tick(160, 240);
+            ob->insert_limit_order(true, 1, sz * 10000);
+            ob->insert_limit_order(false, 100, sz * 10000);
+            for( int n = 0; n < 500 * (i % 7 + 1); ++n ){
+                bool buy = (gen() % 2) != 0;
+                if( gen() % 4 )
+                    ob->insert_limit_order(buy, tick(gen) / 4.0, sz);
+                else
+                    ob->insert_market_order(buy, sz);
+            }
+        };
+    };
+
+    /* the same streams, one at a time, on this thread */
+    vector<BacktestRunner::job_result> expected(NJOBS);
+    for( int i = 0; i < NJOBS; ++i ){
+        if( i == BAD_JOB )
+            continue;
+        SimpleOrderbook::UseInlineExecution(true, true);
+        FullInterface *ob = proxy.create(1, 100);
+        SimpleOrderbook::UseInlineExecution(false, true);
+        stream(i)(ob);
+        expected[i].volume = ob->volume();
+        expected[i].last_price = ob->last_price();
+        expected[i].ntrades = ob->time_and_sales().size();
+        proxy.destroy(ob);
+    }
+
+    BacktestRunner runner(4);
+    if( runner.nthreads() != 4 )
+        return 1;
+    for( int i = 0; i < NJOBS; ++i ){
+        if( runner.add(proxy, 1, 100, stream(i)) != static_cast<size_t>(i) )
+            return 2;
+    }
+
+    vector<BacktestRunner::job_result> results = runner.run();
+    if( results.size() != NJOBS || runner.size() != 0 )
+        return 3;
+
+    for( int i = 0; i < NJOBS; ++i ){
+        const BacktestRunner::job_result& r = results[i];
+        if( i == BAD_JOB ){
+            if( r )
+                return 4;
+            try{
+                rethrow_exception(r.error);
+            }catch( std::invalid_argument& e ){
+                out<< "job " << i << ": " << e.what() << endl;
+            }
+            continue;
+        }
+        if( !r ){
+            try{
+                rethrow_exception(r.error);
+            }catch( std::exception& e ){
+                out<< "job " << i << ": " << e.what() << endl;
+            }
+            return 5;
+        }
+        if( r.volume != expected[i].volume
+            || r.last_price != expected[i].last_price
+            || r.ntrades != expected[i].ntrades ){
+            return 6;
+        }
+    }
+    out<< "job 0: " << results[0].volume << " " << results[0].elapsed.count()
+       << endl;
+
+    /* the runner can be reused */
+    runner.add( [&](){ return proxy.create(1, 100); }, stream(0) );
+    results = runner.run();
+    if( results.size() != 1 || results[0].volume != expected[0].volume )
+        return 7;
+
+    return 0;
+}
+
+
+int
+TEST_depth_deltas_1(FullInterface *full_orderbook, std::ostream& out)
+{
+    using book_type = map<double, pair<size_t, side_of_market>>;
+
+    ManagementInterface *orderbook =
+            dynamic_cast<ManagementInterface*>(full_orderbook);
+
+    auto conv = [&](double d){ return orderbook->price_to_tick(d); };
+
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+
+    /* rebuild the book from the deltas; seq #s must be gap-free */
+    struct replica_state {
+        book_type book;
+        unsigned long long seq = 0;
+        bool started = false;
+    };
+    FeedReplicas<depth_delta, replica_state> replicas( orderbook, 8,
+        [](replica_state& r, const depth_delta& d){
+            if( r.started && d.seq != r.seq && d.seq != r.seq + 1 )
+                return false;
+            r.started = true;
+            r.seq = d.seq;
+            if( d.size )
+                r.book[d.price] = make_pair(d.size, d.side);
+            else{
+                auto iter = r.book.find(d.price);
+                if( iter == r.book.end() || iter->second.second != d.side )
+                    return false;
+                r.book.erase(iter);
+            }
+            return true;
+        },
+        [&](const replica_state& r){
+            return r.book == orderbook->market_depth(30);
+        } );
+    auto& early = replicas.early; // small enough to spill
+    auto& late = replicas.late;
+
+    /* some depth before anyone subscribes */
+    for( int i = 1; i <= 3; ++i ){
+        orderbook->insert_limit_order(true, conv(beg + i*incr), sz * i);
+        orderbook->insert_limit_order(false, conv(beg + (19-i)*incr), sz * i);
+    }
+
+    if( !replicas.subscribe_early() )
+        return 1;
+    if( !replicas.synced(early) )
+        return 2;
+
+    /* a bracket's target grows in place on each partial fill */
+    orderbook->insert_limit_order( true, conv(beg + 5*incr), sz, nullptr,
+        AdvancedOrderTicketBRACKET::build_sell_stop(
+            conv(beg + 4*incr), conv(beg + 10*incr),
+            condition_trigger::fill_partial) );
+    orderbook->insert_market_order(false, sz * 2 / 5);
+    orderbook->insert_market_order(false, sz * 3 / 10);
+    if( !replicas.synced(early)
+        || early.state.book[conv(beg + 10*incr)].first != sz * 7 / 10 )
+        return 9;
+
+    vector<id_type> orders;
+    int ret = random_flow( orderbook, 7, 1000,
+        flow_market | flow_pull | flow_replace | flow_modify, orders,
+        [&](int i){ return replicas.step(i) ? 0 : 3; } );
+    if( ret )
+        return ret;
+
+    if( !replicas.synced(late) )
+        return 4;
+    if( late.state.seq != early.state.seq )
+        return 5;
+    out<< "seq: " << early.state.seq << " levels: " << early.state.book.size()
+       << endl;
+
+    /* no change, no delta */
+    orderbook->insert_stop_order(true, conv(beg + 19*incr), sz);
+    if( !early.ring.empty() )
+        return 6;
+
+    if( !orderbook->unsubscribe_depth_deltas(&early.ring)
+        || orderbook->unsubscribe_depth_deltas(&early.ring) )
+        return 7;
+    orderbook->insert_limit_order(true, conv(beg + incr), sz);
+    if( !early.ring.empty() || late.ring.empty() )
+        return 8;
+    orderbook->unsubscribe_depth_deltas(&late.ring);
+
+    return 0;
+}
+
+
+int
+TEST_order_events_1(FullInterface *full_orderbook, std::ostream& out)
+{
+    ManagementInterface *orderbook =
+            dynamic_cast<ManagementInterface*>(full_orderbook);
+
+    auto conv = [&](double d){ return orderbook->price_to_tick(d); };
+
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+
+    /* rebuild the resting orders from the events */
+    struct replica_state {
+        map<id_type, order_event> orders;
+        unsigned long long window = 0;
+        size_t nfills = 0;
+    };
+    FeedReplicas<order_event, replica_state> replicas( orderbook, 16,
+        [](replica_state& r, const order_event& e){
+            if( e.window < r.window )
+                return false;
+            r.window = e.window;
+            auto iter = r.orders.find(e.id);
+            switch( e.type ){
+            case order_event_type::add:
+                if( iter != r.orders.end() )
+                    return false;
+                r.orders[e.id] = e;
+                break;
+            case order_event_type::fill:
+                ++r.nfills;
+                if( iter == r.orders.end() ) // didn't rest
+                    break;
+                if( iter->second.size < e.size || iter->second.buy != e.buy )
+                    return false;
+                if( (iter->second.size -= e.size) == 0 )
+                    r.orders.erase(iter);
+                break;
+            case order_event_type::modify:
+                if( iter == r.orders.end() )
+                    return false;
+                iter->second.size = e.size;
+                iter->second.tick = e.tick;
+                break;
+            default: // cancel, stop_trigger
+                if( iter == r.orders.end() || iter->second.size != e.size )
+                    return false;
+                r.orders.erase(iter);
+            }
+            return true;
+        },
+        [&](const replica_state& r){
+            if( r.nfills % 2 ) // both sides of every fill
+                return false;
+            for( auto& p : r.orders ){
+                const order_event& e = p.second;
+                order_info oi = orderbook->get_order_info(e.id);
+                double price = (e.order == order_type::limit) ? oi.limit
+                                                              : oi.stop;
+                if( oi.type != e.order || oi.is_buy != e.buy
+                    || oi.size != e.size
+                    || std::llround(price / incr) != e.tick )
+                    return false;
+            }
+            return true;
+        } );
+    auto& early = replicas.early; // small enough to spill
+    auto& late = replicas.late;
+
+    /* some orders before anyone subscribes */
+    vector<id_type> orders;
+    for( int i = 1; i <= 3; ++i ){
+        orders.push_back( orderbook->insert_limit_order(true, conv(beg + i*incr), sz) );
+        orders.push_back( orderbook->insert_limit_order(false, conv(beg + (19-i)*incr), sz) );
+    }
+    orders.push_back( orderbook->insert_stop_order(true, conv(beg + 18*incr), sz) );
+
+    if( !replicas.subscribe_early() )
+        return 1;
+    if( !replicas.synced(early) || early.state.orders.size() != 7 )
+        return 2;
+
+    /* a bracket's children grow in place on each partial fill */
+    orderbook->insert_limit_order( true, conv(beg + 5*incr), sz, nullptr,
+        AdvancedOrderTicketBRACKET::build_sell_stop(
+            conv(beg + 4*incr), conv(beg + 10*incr),
+            condition_trigger::fill_partial) );
+    orderbook->insert_market_order(false, sz * 2 / 5);
+    orderbook->insert_market_order(false, sz * 3 / 10);
+    if( !replicas.synced(early) )
+        return 11;
+    size_t nchildren = 0;
+    for( auto& p : early.state.orders ){
+        const order_event& e = p.second;
+        if( !e.buy && (e.tick == std::llround(conv(beg + 4*incr) / incr)
+                       || e.tick == std::llround(conv(beg + 10*incr) / incr)) ){
+            if( e.size != sz * 7 / 10 )
+                return 12;
+            ++nchildren;
+        }
+    }
+    if( nchildren != 2 )
+        return 13;
+
+    int ret = random_flow( orderbook, 5, 1000,
+        flow_market | flow_pull | flow_replace | flow_modify | flow_stop
+            | flow_stop_limit, orders,
+        [&](int i){ return replicas.step(i) ? 0 : 3; } );
+    if( ret )
+        return ret;
+
+    if( !replicas.synced(early) )
+        return 4;
+    if( !replicas.synced(late)
+        || late.state.orders.size() != early.state.orders.size() )
+        return 5;
+    for( id_type id : orders ){ // nothing missing
+        if( orderbook->get_order_info(id) && !early.state.orders.count(id) )
+            return 6;
+    }
+    if( early.state.window > orderbook->get_top_of_book().window )
+        return 7;
+    out<< "resting: " << early.state.orders.size() << " fills: "
+       << early.state.nfills << " window: " << early.state.window << endl;
+
+    /* a replace is a cancel and an add that points back to it */
+    id_type id1 = orderbook->insert_limit_order(true, conv(beg + incr), sz);
+    id_type id2 = orderbook->replace_with_limit_order(id1, true, conv(beg + incr), sz);
+    vector<order_event> events;
+    early.ring.pop(events);
+    if( events.size() != 3 || events[1].type != order_event_type::cancel
+        || events[1].id != id1 || events[2].type != order_event_type::add
+        || events[2].id != id2 || events[2].parent_id != id1 )
+        return 8;
+
+    if( !orderbook->unsubscribe_order_events(&early.ring)
+        || orderbook->unsubscribe_order_events(&early.ring) )
+        return 9;
+    orderbook->pull_order(id2);
+    if( !early.ring.empty() || late.ring.empty() )
+        return 10;
+    orderbook->unsubscribe_order_events(&late.ring);
+
+    return 0;
+}
+
+
+int
+TEST_depth_levels_1(FullInterface *orderbook, std::ostream& out)
+{
+    auto conv = [&](double d){ return orderbook->price_to_tick(d); };
+
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+
+    depth_level levels[32];
+    if( orderbook->bid_depth_levels(levels, 32)
+        || orderbook->ask_depth_levels(levels, 32) )
+        return 1;
+    if( orderbook->bid_depth_levels(nullptr, 0) )
+        return 2;
+
+    /* same levels as bid/ask_depth, inside out, w/ the # of live orders */
+    auto check = [&](bool buy, size_t n){
+        size_t nlev = buy ? orderbook->bid_depth_levels(levels, n)
+                          : orderbook->ask_depth_levels(levels, n);
+        map<double,size_t> md = buy ? orderbook->bid_depth(30)
+                                    : orderbook->ask_depth(30);
+        if( nlev != std::min(md.size(), n) )
+            return false;
+        auto iter = md.begin();
+        auto riter = md.rbegin();
+        for( size_t i = 0; i < nlev; ++i ){
+            const pair<const double,size_t>& l = buy ? *riter++ : *iter++;
+            if( levels[i].price != l.first || levels[i].size != l.second
+                || levels[i].count == 0 || levels[i].count > l.second / sz )
+                return false;
+        }
+        return true;
+    };
+
+    vector<id_type> orders;
+    int ret = random_flow( orderbook, 11, 500, flow_market | flow_pull, orders,
+        [&](int i){
+            if( (i % 25) == 24
+                && (!check(true, 32) || !check(false, 32)
+                    || !check(true, 2) || !check(false, 2)) )
+                return 3;
+            return 0;
+        } );
+    if( ret )
+        return ret;
+
+    /* order count at one level */
+    double p = conv(beg + incr);
+    while( orderbook->bid_depth_levels(levels, 32) ){
+        orderbook->insert_market_order(false, levels[0].size);
+    }
+    for( int i = 0; i < 3; ++i )
+        orderbook->insert_limit_order(true, p, sz);
+    orderbook->insert_limit_order(true, conv(beg), sz);
+    if( orderbook->bid_depth_levels(levels, 32) != 2
+        || levels[0].price != p || levels[0].size != 3 * sz
+        || levels[0].count != 3 || levels[1].count != 1 )
+        return 4;
+    out<< "levels[0]: " << levels[0].price << " " << levels[0].size
+       << " " << levels[0].count << endl;
+
+    return 0;
+}
+
+
+int
+TEST_stop_depth_1(FullInterface *orderbook, std::ostream& out)
+{
+    auto conv = [&](double d){ return orderbook->price_to_tick(d); };
+
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+
+    if( !orderbook->stop_depth(30).empty() || orderbook->total_stop_size() )
+        return 1;
+
+    /* what's left of every stop we've ever inserted, by stop price */
+    vector<id_type> orders;
+    auto check = [&](){
+        map<double, pair<size_t,size_t>> md;
+        size_t buys = 0, sells = 0;
+        for( id_type id : orders ){
+            order_info oi = orderbook->get_order_info(id);
+            if( oi.type != order_type::stop && oi.type != order_type::stop_limit )
+                continue;
+            auto& l = md[oi.stop];
+            (oi.is_buy ? l.first : l.second) += oi.size;
+            (oi.is_buy ? buys : sells) += oi.size;
+        }
+        return md == orderbook->stop_depth(30)
+            && buys == orderbook->total_buy_stop_size()
+            && sells == orderbook->total_sell_stop_size()
+            && buys + sells == orderbook->total_stop_size();
+    };
+
+    /* so triggered stops always have something to hit */
+    orderbook->insert_limit_order(true, conv(beg), sz * 1000);
+    orderbook->insert_limit_order(false, conv(beg + 19*incr), sz * 1000);
+
+    int ret = random_flow( orderbook, 13, 1000,
+        flow_market | flow_pull | flow_modify | flow_stop | flow_stop_limit,
+        orders, [&](int i){ return ((i % 20) == 19 && !check()) ? 2 : 0; } );
+    if( ret )
+        return ret;
+
+    /* only the levels near the last trade */
+    double last = orderbook->last_price();
+    for( auto& l : orderbook->stop_depth(2) ){
+        if( std::abs(l.first - last) > 2.5 * incr )
+            return 3;
+    }
+    out<< "stop levels: " << orderbook->stop_depth(30).size()
+       << " buy: " << orderbook->total_buy_stop_size()
+       << " sell: " << orderbook->total_sell_stop_size() << endl;
+
+    for( id_type id : orders )
+        orderbook->pull_order(id);
+    if( !orderbook->stop_depth(30).empty() || orderbook->total_stop_size() )
+        return 4;
+
+    return 0;
+}
+
+
+int
+TEST_bars_1(FullInterface *full_orderbook, std::ostream& out)
+{
+    ManagementInterface *orderbook =
+            dynamic_cast<ManagementInterface*>(full_orderbook);
+
+    clock_type::time_point t0 = clock_type::time_point() + chrono::hours(1);
+
+    bar bars[64];
+    try{
+        orderbook->bars(chrono::seconds(1), bars, 64);
+        return 1;
+    }catch( std::invalid_argument& e ){
+    }
+    try{
+        orderbook->add_bar_interval(chrono::seconds(0), 10);
+        return 2;
+    }catch( std::invalid_argument& e ){
+    }
+
+    orderbook->set_clock( simulated_clock(t0, chrono::milliseconds(300)) );
+    orderbook->add_bar_interval(chrono::seconds(1), 8);
+    orderbook->add_bar_interval(chrono::seconds(5), 64);
+    if( orderbook->bars(chrono::seconds(1), bars, 64) )
+        return 3;
+
+    vector<id_type> orders;
+    random_flow(orderbook, 17, 500, flow_market, orders);
+
+    /* rebuild them from the tape */
+    auto check = [&](clock_type::duration interval, size_t history, size_t n){
+        vector<bar> expected;
+        double notional = 0;
+        for( const timesale_entry_type& t : orderbook->time_and_sales() ){
+            clock_type::time_point tp = get<0>(t);
+            double p = get<1>(t);
+            size_t s = get<2>(t);
+            clock_type::time_point start = tp - (tp.time_since_epoch() % interval);
+            if( expected.empty() || expected.back().start != start ){
+                expected.push_back( bar() );
+                expected.back().start = start;
+                expected.back().open = expected.back().high
+                                     = expected.back().low = p;
+                notional = 0;
+            }
+            bar& b = expected.back();
+            b.high = std::max(b.high, p);
+            b.low = std::min(b.low, p);
+            b.close = p;
+            b.volume += s;
+            ++b.ntrades;
+            notional += p * s;
+            b.vwap = notional / b.volume;
+        }
+        size_t nbars = orderbook->bars(interval, bars, n);
+        if( nbars != std::min(std::min(n, history), expected.size()) )
+            return false;
+        for( size_t i = 0; i < nbars; ++i ){
+            const bar& e = expected[expected.size() - nbars + i];
+            const bar& b = bars[i];
+            if( b.start != e.start || b.open != e.open || b.high != e.high
+                || b.low != e.low || b.close != e.close || b.volume != e.volume
+                || b.vwap != e.vwap || b.ntrades != e.ntrades )
+                return false;
+        }
+        return true;
+    };
+    if( orderbook->time_and_sales().size() < 50 )
+        return 4;
+    if( !check(chrono::seconds(1), 8, 64) || !check(chrono::seconds(1), 8, 3) )
+        return 5;
+    if( !check(chrono::seconds(5), 64, 64) || !check(chrono::seconds(5), 64, 1) )
+        return 6;
+    out<< "trades: " << orderbook->time_and_sales().size() << " 5s bars: "
+       << orderbook->bars(chrono::seconds(5), bars, 64) << endl;
+
+    if( !orderbook->remove_bar_interval(chrono::seconds(1))
+        || orderbook->remove_bar_interval(chrono::seconds(1)) )
+        return 7;
+    orderbook->remove_bar_interval(chrono::seconds(5));
+    orderbook->set_clock(nullptr);
+
+    return 0;
+}
+
+
+int
+TEST_estimate_fill_1(FullInterface *orderbook, std::ostream& out)
+{
+    auto conv = [&](double d){ return orderbook->price_to_tick(d); };
+
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+    auto price = [&](int i){ return conv(beg + i*incr); };
+    auto close = [](double d1, double d2){
+        return std::abs(d1 - d2) <= 1e-9 * std::max(1.0, std::abs(d2));
+    };
+
+    fill_estimate fe = orderbook->estimate_fill(true, sz);
+    if( fe.filled || fe.levels || fe.vwap )
+        return 1;
+    try{
+        orderbook->estimate_fill(true, 0);
+        return 2;
+    }catch( std::invalid_argument& e ){
+    }
+
+    vector<id_type> ids = {
+        orderbook->insert_limit_order(false, price(10), sz),
+        orderbook->insert_limit_order(false, price(11), sz * 2),
+        orderbook->insert_limit_order(false, price(12), sz * 3, nullptr,
+                                      AdvancedOrderTicketAON::build()),
+        orderbook->insert_limit_order(false, price(13), sz * 2),
+        orderbook->insert_limit_order(true, price(5), sz),
+        orderbook->insert_limit_order(true, price(4), sz * 2)
+    };
+    auto md = orderbook->market_depth(30);
+    auto amd = orderbook->aon_market_depth();
+
+    /* size, filled, levels, worst, notional / sz */
+    vector<std::tuple<size_t, size_t, size_t, int, double>> buys = {
+        make_tuple(sz * 2, sz * 2, 2, 11, price(10) + price(11)),
+        /* AON doesn't fit in what's left */
+        make_tuple(sz * 4, sz * 4, 3, 13,
+                   price(10) + 2 * price(11) + price(13)),
+        make_tuple(sz * 6, sz * 6, 3, 12,
+                   price(10) + 2 * price(11) + 3 * price(12)),
+        make_tuple(sz * 100, sz * 8, 4, 13,
+                   price(10) + 2 * price(11) + 3 * price(12) + 2 * price(13))
+    };
+    for( auto& b : buys ){
+        fe = orderbook->estimate_fill(true, get<0>(b));
+        if( fe.filled != get<1>(b) || fe.levels != get<2>(b)
+            || fe.worst_price != price(get<3>(b))
+            || !close(fe.vwap, get<4>(b) * sz / fe.filled) )
+            return 3;
+    }
+    fe = orderbook->estimate_fill(false, sz * 2);
+    if( fe.filled != sz * 2 || fe.levels != 2 || fe.worst_price != price(4)
+        || !close(fe.vwap, (price(5) + price(4)) / 2) )
+        return 4;
+    if( md != orderbook->market_depth(30) || amd != orderbook->aon_market_depth() )
+        return 5;
+
+    /* against what a market order actually gets (no AONs) */
+    for( id_type id : ids )
+        orderbook->pull_order(id);
+
+    /* a market order after every 20 limits */
+    std::mt19937 gen(19);
+    vector<id_type> orders;
+    int ret = random_flow( orderbook, 19, 400, 0, orders, [&](int i){
+        if( (i % 20) != 19 )
+            return 0;
+        bool buy = (gen() % 2) != 0;
+        size_t s = (gen() % 30 + 1) * sz;
+        fe = orderbook->estimate_fill(buy, s);
+
+        size_t ntrades = orderbook->time_and_sales().size();
+        try{
+            orderbook->insert_market_order(buy, s);
+            if( fe.filled != s )
+                return 6;
+        }catch( liquidity_exception& e ){
+            if( fe.filled == s )
+                return 7;
+        }
+        const vector<timesale_entry_type>& ts = orderbook->time_and_sales();
+        size_t filled = 0, levels = 0;
+        double notional = 0, last = 0;
+        for( size_t t = ntrades; t < ts.size(); ++t ){
+            if( !filled || get<1>(ts[t]) != last )
+                ++levels;
+            last = get<1>(ts[t]);
+            filled += get<2>(ts[t]);
+            notional += last * get<2>(ts[t]);
+        }
+        if( fe.filled != filled || fe.levels != levels
+            || (filled && (fe.worst_price != last
+                           || !close(fe.vwap, notional / filled))) )
+            return 8;
+        return 0;
+    } );
+    if( ret )
+        return ret;
+    out<< "last: " << fe.filled << " @ " << fe.vwap << " thru "
+       << fe.worst_price << " (" << fe.levels << " levels)" << endl;
+
+    return 0;
+}
+
+
+int
+TEST_order_status_1(FullInterface *orderbook, std::ostream& out)
+{
+    auto conv = [&](double d){ return orderbook->price_to_tick(d); };
+
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+    auto price = [&](int i){ return conv(beg + i*incr); };
+    auto tick = [&](double p){ return std::llround(p / incr); };
+
+    if( orderbook->get_order_status(nullptr, 0, nullptr) )
+        return 1;
+
+    vector<id_type> ids;
+    ids.push_back( orderbook->insert_limit_order(true, price(2), sz, nullptr,
+                   AdvancedOrderTicket::null, make_client_id(7)) );
+    ids.push_back( orderbook->insert_limit_order(false, price(15), sz * 2,
+                   nullptr, AdvancedOrderTicketAON::build()) );
+    ids.push_back( orderbook->insert_limit_order(true, price(3), sz, nullptr,
+                   AdvancedOrderTicketOCO::build_limit(true, price(1), sz)) );
+    ids.push_back( orderbook->insert_stop_order(false, price(1), price(1), sz) );
+    ids.push_back( 999999 );
+
+    random_flow( orderbook, 23, 300,
+        flow_market | flow_pull | flow_stop | flow_stop_limit, ids );
+    ids.push_back( make_client_id(7) );
+
+    vector<order_status> status( ids.size() );
+    size_t nfound = orderbook->get_order_status(ids.data(), ids.size(),
+                                                status.data());
+    size_t nactive = 0;
+    for( size_t i = 0; i < ids.size(); ++i ){
+        order_info oi = orderbook->get_order_info(ids[i]);
+        const order_status& st = status[i];
+        if( st.type != oi.type )
+            return 2;
+        if( !oi )
+            continue;
+        ++nactive;
+        if( st.is_buy != oi.is_buy || st.size != oi.size
+            || st.limit_tick != (oi.limit ? tick(oi.limit) : 0)
+            || st.stop_tick != (oi.stop ? tick(oi.stop) : 0)
+            || st.condition != oi.advanced.condition()
+            || st.trigger != oi.advanced.trigger() )
+            return 3;
+    }
+    if( nfound != nactive )
+        return 4;
+    /* the client ID resolves to the order if it's still there */
+    if( status.back().id != (status[0].type != order_type::null ? ids[0] : 0)
+        || status[4].type != order_type::null )
+        return 5;
+    out<< "active: " << nactive << "/" << ids.size() << endl;
+
+    return 0;
+}
+
+
+int
+TEST_visit_1(FullInterface *orderbook, std::ostream& out)
+{
+    auto conv = [&](double d){ return orderbook->price_to_tick(d); };
+
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+    auto price = [&](int i){ return conv(beg + i*incr); };
+    auto tick = [&](double p){ return std::llround(p / incr); };
+
+    vector<id_type> ids;
+    ids.push_back( orderbook->insert_limit_order(false, price(15), sz * 2,
+                   nullptr, AdvancedOrderTicketAON::build()) );
+    ids.push_back( orderbook->insert_limit_order(true, price(3), sz, nullptr,
+                   AdvancedOrderTicketOCO::build_limit(true, price(1), sz)) );
+
+    random_flow( orderbook, 31, 300,
+        flow_market | flow_pull | flow_stop | flow_stop_limit, ids );
+
+    /* levels match the flat depth */
+    depth_level buf[64];
+    for( side_of_market side : {side_of_market::bid, side_of_market::ask} ){
+        bool bid = (side == side_of_market::bid);
+        size_t ndepth = bid ? orderbook->bid_depth_levels(buf, 64)
+                            : orderbook->ask_depth_levels(buf, 64);
+        vector<level_view> levels;
+        size_t n = orderbook->visit_levels( side, 0, 0,
+            [&](const level_view& v){ levels.push_back(v); return true; } );
+        if( n != ndepth || levels.size() != ndepth )
+            return 1;
+        for( size_t i = 0; i < n; ++i ){
+            if( levels[i].price != buf[i].price
+                || levels[i].size != buf[i].size
+                || levels[i].count != buf[i].count
+                || levels[i].tick != tick(buf[i].price)
+                || levels[i].side != side )
+                return 2;
+        }
+    }
+
+    size_t nbid = orderbook->bid_depth_levels(buf, 64);
+    size_t nask = orderbook->ask_depth_levels(buf, 64);
+    size_t nall = orderbook->visit_levels( side_of_market::both, 0, 0,
+        [](const level_view&){ return true; } );
+    if( nall != nbid + nask )
+        return 3;
+
+    /* in range */
+    bool in_range = true;
+    size_t nrange = orderbook->visit_levels( side_of_market::both,
+        price(6), price(12), [&](const level_view& v){
+            in_range &= (v.price >= price(6) && v.price <= price(12));
+            return true;
+        } );
+    if( !in_range || nrange > nall )
+        return 4;
+
+    /* stops early */
+    size_t seen = 0;
+    auto stop_at_2 = [&](const level_view&){ return ++seen < 2; };
+    if( orderbook->visit_levels(side_of_market::both, 0, 0, stop_at_2)
+        != std::min<size_t>(nall, 2) || seen != std::min<size_t>(nall, 2) )
+        return 5;
+
+    /* orders match get_order_info, high price to low */
+    vector<order_view> orders;
+    size_t norders = orderbook->visit_orders( side_of_trade::both, 0, 0,
+        order_type::null, [&](const order_view& v){
+            orders.push_back(v); // can't call into the book from here
+            return true;
+        } );
+    std::set<id_type> visited;
+    double last = std::numeric_limits<double>::max();
+    bool ok = true;
+    for( const order_view& v : orders ){
+        order_info oi = orderbook->get_order_info(v.id);
+        double p = (v.type == order_type::limit) ? v.limit : v.stop;
+        ok &= (oi.type == v.type && oi.is_buy == v.is_buy
+               && oi.size == v.size && oi.limit == v.limit
+               && oi.stop == v.stop && v.tick == tick(p)
+               && oi.advanced.condition() == v.condition
+               && p <= last);
+        last = p;
+        visited.insert(v.id);
+    }
+    if( !ok || norders != visited.size() )
+        return 6;
+    for( id_type id : ids ){
+        if( orderbook->get_order_info(id) && !visited.count(id) )
+            return 7;
+    }
+
+    /* by side and type */
+    size_t nbuy_stops = orderbook->visit_orders( side_of_trade::buy, 0, 0,
+        order_type::stop, [&](const order_view& v){
+            ok &= (v.is_buy && v.type == order_type::stop);
+            return true;
+        } );
+    size_t nsell_limits = orderbook->visit_orders( side_of_trade::sell,
+        price(4), 0, order_type::limit, [&](const order_view& v){
+            ok &= (!v.is_buy && v.type == order_type::limit
+                   && v.limit >= price(4));
+            return true;
+        } );
+    if( !ok || nbuy_stops + nsell_limits > norders )
+        return 8;
+
+    try{
+        orderbook->visit_orders( side_of_trade::both, 0, 0,
+                                 order_type::market,
+                                 [](const order_view&){ return true; } );
+        return 9;
+    }catch( std::invalid_argument& e ){
+    }
+    try{
+        orderbook->visit_levels( side_of_market::both, price(5), price(4),
+                                 [](const level_view&){ return true; } );
+        return 10;
+    }catch( std::invalid_argument& e ){
+    }
+
+    out<< "levels: " << nall << " orders: " << norders << " buy stops: "
+       << nbuy_stops << " sell limits: " << nsell_limits << endl;
+
+    return 0;
+}
+
+
+#endif /* RUN_FUNCTIONAL_TESTS */
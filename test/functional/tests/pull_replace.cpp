@@ -24,6 +24,7 @@ along with this program. If not, see http://www.gnu.org/licenses.
 #include <tuple>
 #include <random>
 #include <iostream>
+#include <future>
 
 using namespace sob;
 using namespace std;
@@ -638,6 +639,527 @@ TEST_replace_order_ASYNC_1(FullInterface *orderbook, std::ostream& out)
     return 0;
 }
 
+
+int
+TEST_client_ids_1(FullInterface *orderbook, std::ostream& out)
+{
+    auto conv = [&](double d){ return orderbook->price_to_tick(d); };
+
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+
+    id_type cid1 = make_client_id(1);
+    id_type cid2 = make_client_id(2);
+
+    id_type id1 = orderbook->insert_limit_order(true, conv(beg+incr), sz,
+                                                callback, AdvancedOrderTicket::null,
+                                                cid1);
+    order_info of = orderbook->get_order_info(cid1);
+    if( of.limit != conv(beg+incr) || of.size != sz || !of.is_buy ){
+        return 1;
+    }
+
+    /* can't reuse a client id while its order is live */
+    try{
+        orderbook->insert_limit_order(true, beg, sz, callback,
+                                      AdvancedOrderTicket::null, cid1);
+        return 2;
+    }catch( std::invalid_argument& e ){
+        out<< "caught: " << e.what() << endl;
+    }
+
+    /* client ids need the flag */
+    try{
+        orderbook->insert_limit_order(true, beg, sz, callback,
+                                      AdvancedOrderTicket::null, 2);
+        return 3;
+    }catch( std::invalid_argument& e ){
+        out<< "caught: " << e.what() << endl;
+    }
+
+    /* replace moves the client id to the new order */
+    id_type id2 = orderbook->replace_with_limit_order(cid1, true, beg, 2*sz,
+                                                      callback);
+    if( !id2 || id2 == id1 ){
+        return 4;
+    }
+    of = orderbook->get_order_info(cid1);
+    if( of.limit != beg || of.size != 2*sz ){
+        return 5;
+    }
+    if( orderbook->get_order_info(id1) ){
+        return 6;
+    }
+    dump_orders(orderbook, out);
+
+    if( !orderbook->pull_order(cid1) ){
+        return 7;
+    }
+    if( orderbook->pull_order(cid1) || orderbook->pull_order(cid2) ){
+        return 8;
+    }
+
+    /* once the order is gone the client id can be used again */
+    orderbook->insert_stop_order(false, conv(beg+2*incr), sz, callback,
+                                 AdvancedOrderTicket::null, cid1);
+    orderbook->insert_limit_order(true, conv(beg+2*incr), sz, callback,
+                                  AdvancedOrderTicket::null, cid2);
+    orderbook->insert_limit_order(false, conv(beg+3*incr), sz);
+    orderbook->insert_limit_order(true, beg, sz);
+    dump_orders(orderbook, out);
+
+    /* fill cid2 (triggering the stop); cid1 follows the stop's new id */
+    orderbook->insert_market_order(false, sz);
+    dump_orders(orderbook, out);
+
+    if( orderbook->get_order_info(cid2) ){
+        return 9;
+    }
+    if( orderbook->pull_order(cid2) ){
+        return 10;
+    }
+    if( orderbook->volume() != 2*sz ){
+        return 11;
+    }
+
+    return 0;
+}
+
+
+int
+TEST_client_ids_ASYNC_1(FullInterface *orderbook, std::ostream& out)
+{
+    auto conv = [&](double d){ return orderbook->price_to_tick(d); };
+
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+
+    /* pipeline insert -> replace -> replace -> pull w/o waiting */
+    vector<future<id_type>> futs;
+    for( id_type i = 1; i <= 10; ++i ){
+        id_type cid = make_client_id(i);
+        futs.push_back( orderbook->insert_limit_order_async(
+            true, beg, sz, callback, AdvancedOrderTicket::null, cid) );
+        futs.push_back( orderbook->replace_with_limit_order_async(
+            cid, true, conv(beg+incr), sz, callback) );
+        futs.push_back( orderbook->replace_with_limit_order_async(
+            cid, true, conv(beg+2*incr), 2*sz, callback) );
+        if( i % 2 )
+            futs.push_back( orderbook->pull_order_async(cid) );
+    }
+
+    for( auto& f : futs ){
+        if( !f.get() )
+            return 1;
+    }
+    orderbook->wait_for_async_callbacks();
+    dump_orders(orderbook, out);
+
+    if( orderbook->total_bid_size() != 5 * 2 * sz ){
+        return 2;
+    }else if( orderbook->bid_price() != conv(beg+2*incr) ){
+        return 3;
+    }
+
+    for( id_type i = 2; i <= 10; i += 2 ){
+        if( !orderbook->pull_order_async(make_client_id(i)).get() )
+            return 4;
+    }
+
+    if( orderbook->total_bid_size() != 0 ){
+        return 5;
+    }
+
+    return 0;
+}
+
+
+int
+TEST_pull_all_1(FullInterface *orderbook, std::ostream& out)
+{
+    auto conv = [&](double d){ return orderbook->price_to_tick(d); };
+
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+
+    size_t ncancels = 0;
+    auto cancel_cb = [&](callback_msg msg, id_type id1, id_type id2,
+                         double price, size_t size){
+        if( msg == callback_msg::cancel )
+            ++ncancels;
+    };
+
+    const owner_type o1 = 1, o2 = 2, o3 = 3;
+    AdvancedOrderTicket aot = AdvancedOrderTicket::null;
+
+    id_type id1 = orderbook->insert_limit_order(true, beg, sz, cancel_cb, aot,
+                                                0, o1);
+    orderbook->insert_limit_order(true, conv(beg+incr), sz, cancel_cb, aot,
+                                  0, o1);
+    orderbook->insert_limit_order(true, conv(beg+2*incr), sz, cancel_cb, aot,
+                                  0, o1);
+    orderbook->insert_limit_order(false, conv(beg+6*incr), sz, cancel_cb, aot,
+                                  0, o1);
+    id_type sid1 = orderbook->insert_stop_order(false, conv(beg+incr), sz,
+                                                cancel_cb, aot, 0, o1);
+    id_type sid2 = orderbook->insert_stop_order(true, conv(beg+7*incr),
+                                                conv(beg+7*incr), sz,
+                                                cancel_cb, aot, 0, o1);
+    orderbook->insert_limit_order(true, conv(beg+incr), sz, cancel_cb, aot,
+                                  0, o2);
+    dump_orders(orderbook, out);
+
+    try{
+        orderbook->pull_all(0);
+        return 1;
+    }catch( std::invalid_argument& e ){
+        out<< "caught: " << e.what() << endl;
+    }
+    try{
+        orderbook->pull_all(o1, pull_filter(side_of_trade::both, 0, 0,
+                                            order_type::market));
+        return 2;
+    }catch( std::invalid_argument& e ){
+        out<< "caught: " << e.what() << endl;
+    }
+
+    /* o1's buy limits from beg+incr up, in one window w/ all the callbacks */
+    unsigned long long window = orderbook->get_top_of_book().window;
+    size_t n = orderbook->pull_all(o1, pull_filter(side_of_trade::buy,
+                                                   conv(beg+incr), 0,
+                                                   order_type::limit));
+    if( n != 2 || ncancels != 2 ){
+        out<< "pulled: " << n << ", cancels: " << ncancels << endl;
+        return 3;
+    }
+    if( orderbook->get_top_of_book().window != window + 1 ){
+        return 4;
+    }
+    if( orderbook->total_bid_size() != 2*sz
+        || orderbook->bid_price() != conv(beg+incr) ){
+        return 5;
+    }
+    dump_orders(orderbook, out);
+
+    /* a replace keeps the owner */
+    id_type id2 = orderbook->replace_with_limit_order(id1, false,
+                                                      conv(beg+5*incr), sz,
+                                                      cancel_cb);
+    if( !id2 ){
+        return 6;
+    }
+
+    n = orderbook->pull_all(o1, pull_filter(side_of_trade::both, 0, 0,
+                                            order_type::stop));
+    if( n != 1 || orderbook->get_order_info(sid1)
+        || !orderbook->get_order_info(sid2) ){
+        return 7;
+    }
+
+    n = orderbook->pull_all(o1);
+    if( n != 3 || orderbook->total_ask_size() != 0
+        || orderbook->get_order_info(sid2) ){
+        return 8;
+    }
+    if( orderbook->pull_all(o1) || orderbook->pull_all(o3) ){
+        return 9;
+    }
+    if( orderbook->total_bid_size() != sz ){ // o2's
+        return 10;
+    }
+
+    /* a triggered stop keeps the owner */
+    orderbook->insert_stop_order(true, conv(beg+3*incr), conv(beg+3*incr), sz,
+                                 cancel_cb, aot, 0, o3);
+    orderbook->insert_limit_order(false, conv(beg+3*incr), sz);
+    orderbook->insert_market_order(true, sz);
+    dump_orders(orderbook, out);
+    if( orderbook->total_bid_size() != 2*sz ){
+        return 11;
+    }
+    if( orderbook->pull_all(o3) != 1 || orderbook->pull_all(o2) != 1 ){
+        return 12;
+    }
+    if( orderbook->total_bid_size() != 0 ){
+        return 13;
+    }
+
+    return 0;
+}
+
+
+int
+TEST_pull_all_ASYNC_1(FullInterface *orderbook, std::ostream& out)
+{
+    auto conv = [&](double d){ return orderbook->price_to_tick(d); };
+
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+
+    /* interleave owners, mass pull one of them w/o waiting */
+    vector<future<id_type>> futs;
+    for( owner_type i = 0; i < 20; ++i ){
+        OrderBatch batch;
+        batch.add_limit_order(true, conv(beg+(i%4)*incr), sz, callback,
+                              AdvancedOrderTicket::null, 0, 1 + i%2);
+        futs.push_back( orderbook->insert_limit_order_async(
+            false, conv(beg+(5+i%4)*incr), sz, callback,
+            AdvancedOrderTicket::null, 0, 1 + i%2) );
+        auto r = orderbook->insert_orders(batch);
+        if( !r[0] )
+            return 1;
+    }
+    future<id_type> npulled = orderbook->pull_all_async(1);
+    for( auto& f : futs ){
+        if( !f.get() )
+            return 2;
+    }
+    if( npulled.get() != 20 ){
+        return 3;
+    }
+    orderbook->wait_for_async_callbacks();
+    dump_orders(orderbook, out);
+
+    if( orderbook->total_bid_size() != 10 * sz
+        || orderbook->total_ask_size() != 10 * sz ){
+        return 4;
+    }
+
+    npulled = orderbook->pull_all_async(2, pull_filter(side_of_trade::sell));
+    if( npulled.get() != 10 || orderbook->total_ask_size() != 0
+        || orderbook->total_bid_size() != 10 * sz ){
+        return 5;
+    }
+    if( orderbook->pull_all_async(2).get() != 10 ){
+        return 6;
+    }
+
+    return 0;
+}
+
+
+int
+TEST_modify_order_1(FullInterface *orderbook, std::ostream& out)
+{
+    auto conv = [&](double d){ return orderbook->price_to_tick(d); };
+
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+
+    id_type cid = make_client_id(1);
+    double p = conv(beg+incr);
+
+    id_type id1 = orderbook->insert_limit_order(true, p, sz, callback);
+    id_type id2 = orderbook->insert_limit_order(true, p, sz, callback,
+                                                AdvancedOrderTicket::null, cid);
+
+    try{
+        orderbook->modify_order(id1, 0);
+        return 1;
+    }catch( std::invalid_argument& e ){
+        out<< "caught: " << e.what() << endl;
+    }
+
+    /* decrease: same id, still first in line */
+    if( orderbook->modify_order(id1, sz/2) != id1 ){
+        return 2;
+    }
+    if( orderbook->get_order_info(id1).size != sz/2
+        || orderbook->total_bid_size() != sz + sz/2 ){
+        return 3;
+    }
+    dump_orders(orderbook, out);
+
+    orderbook->insert_market_order(false, sz/2);
+    if( orderbook->get_order_info(id1) ){
+        return 4;
+    }
+    if( orderbook->get_order_info(id2).size != sz ){
+        return 5;
+    }
+
+    /* increase (via client id): new id, same price, client id follows */
+    id_type id3 = orderbook->modify_order(cid, 2*sz);
+    if( !id3 || id3 == id2 || orderbook->get_order_info(id2) ){
+        return 6;
+    }
+    order_info oi = orderbook->get_order_info(cid);
+    if( oi.size != 2*sz || oi.limit != p || !oi.is_buy ){
+        return 7;
+    }
+
+    /* same size is a no-op, gone is a failure */
+    if( orderbook->modify_order(id3, 2*sz) != id3 ){
+        return 8;
+    }
+    if( orderbook->modify_order(id1, sz) ){
+        return 9;
+    }
+
+    /* stops */
+    id_type id4 = orderbook->insert_stop_order(false, beg, conv(beg+incr),
+                                               sz, callback);
+    if( orderbook->modify_order(id4, sz/4) != id4 ){
+        return 10;
+    }
+    oi = orderbook->get_order_info(id4);
+    if( oi.type != order_type::stop_limit || oi.size != sz/4
+        || oi.stop != beg || oi.limit != conv(beg+incr) ){
+        return 11;
+    }
+    dump_orders(orderbook, out);
+
+    return 0;
+}
+
+
+/*
+ * OCO legs and active bracket/trailing stop orders can't be resized on their
+ * own (either way); the modify should throw and leave every order as it was
+ */
+int
+TEST_modify_order_2(FullInterface *orderbook, std::ostream& out)
+{
+    auto conv = [&](double d){ return orderbook->price_to_tick(d); };
+
+    double beg = orderbook->min_price();
+    double end = orderbook->max_price();
+    double incr = orderbook->tick_size();
+
+    auto with_condition = [&](order_condition cond){
+        vector<order_view> views;
+        orderbook->visit_orders( side_of_trade::both, 0, 0, order_type::null,
+            [&](const order_view& v){
+                if( v.condition == cond )
+                    views.push_back(v);
+                return true;
+            } );
+        return views;
+    };
+
+    auto rejected = [&](id_type id, size_t new_size){
+        try{
+            orderbook->modify_order(id, new_size);
+        }catch( advanced_order_error& e ){
+            out<< "caught: " << e.what() << endl;
+            return true;
+        }
+        return false;
+    };
+
+    /* bracket children go active (at half size) on the partial fill */
+    orderbook->insert_limit_order( true, conv(beg + 5*incr), sz, callback,
+        AdvancedOrderTicketBRACKET::build_sell_stop(
+            conv(beg + 4*incr), conv(beg + 10*incr),
+            condition_trigger::fill_partial) );
+    orderbook->insert_market_order(false, sz/2);
+    dump_orders(orderbook, out);
+
+    vector<order_view> children =
+        with_condition(order_condition::_bracket_active);
+    if( children.size() != 2 ){
+        return 1;
+    }
+    for( const order_view& v : children ){
+        if( !rejected(v.id, sz/4) || !rejected(v.id, sz) ){
+            return 2;
+        }
+    }
+    for( const order_view& v : children ){
+        if( orderbook->get_order_info(v.id).size != sz/2 ){
+            return 3;
+        }
+    }
+
+    /* trailing stop goes active on the fill */
+    orderbook->insert_limit_order(false, conv(beg + 8*incr), sz, callback);
+    orderbook->insert_limit_order( true, conv(beg + 8*incr), sz, callback,
+        AdvancedOrderTicketTrailingStop::build(3) );
+    dump_orders(orderbook, out);
+
+    vector<order_view> trailing =
+        with_condition(order_condition::_trailing_stop_active);
+    if( trailing.size() != 1 ){
+        return 4;
+    }
+    try{
+        orderbook->modify_order_async(trailing[0].id, 2*sz).get();
+        return 5;
+    }catch( advanced_order_error& e ){
+        out<< "caught: " << e.what() << endl;
+    }
+    if( orderbook->get_order_info(trailing[0].id).size != sz ){
+        return 6;
+    }
+
+    /* growing one OCO leg must not cancel the other */
+    orderbook->insert_limit_order( true, conv(beg + incr), sz, callback,
+        AdvancedOrderTicketOCO::build_limit(false, conv(end - incr), sz) );
+    dump_orders(orderbook, out);
+
+    vector<order_view> legs =
+        with_condition(order_condition::one_cancels_other);
+    if( legs.size() != 2 ){
+        return 7;
+    }
+    for( const order_view& v : legs ){
+        if( !rejected(v.id, 2*sz) || !rejected(v.id, sz/2) ){
+            return 8;
+        }
+    }
+    for( const order_view& v : legs ){
+        if( orderbook->get_order_info(v.id).size != sz ){
+            return 9;
+        }
+    }
+    if( with_condition(order_condition::one_cancels_other).size() != 2 ){
+        return 10;
+    }
+    dump_orders(orderbook, out);
+
+    return 0;
+}
+
+
+int
+TEST_modify_order_ASYNC_1(FullInterface *orderbook, std::ostream& out)
+{
+    auto conv = [&](double d){ return orderbook->price_to_tick(d); };
+
+    double beg = orderbook->min_price();
+    double incr = orderbook->tick_size();
+
+    /* pipeline insert -> shrink on client ids w/o waiting */
+    vector<future<id_type>> futs;
+    for( id_type i = 1; i <= 10; ++i ){
+        id_type cid = make_client_id(i);
+        futs.push_back( orderbook->insert_limit_order_async(
+            false, conv(beg+incr), sz, callback, AdvancedOrderTicket::null,
+            cid) );
+        futs.push_back( orderbook->modify_order_async(cid, i) );
+    }
+    for( auto& f : futs ){
+        if( !f.get() )
+            return 1;
+    }
+    orderbook->wait_for_async_callbacks();
+
+    if( orderbook->total_ask_size() != 55 ){
+        return 2;
+    }
+
+    /* shrunk orders kept their place: the first 6 fill 1..6 (21 total) */
+    orderbook->insert_market_order(true, 21);
+    for( id_type i = 1; i <= 10; ++i ){
+        if( (bool)orderbook->get_order_info(make_client_id(i)) != (i > 6) )
+            return 3;
+    }
+    dump_orders(orderbook, out);
+
+    return 0;
+}
+
+
 #endif /* RUN_FUNCTIONAL_TESTS */
 
 
@@ -19,6 +19,7 @@ along with this program. If not, see http://www.gnu.org/licenses.
 #ifdef RUN_PERFORMANCE_TESTS
 
 #include <functional>
+#include <algorithm>
 #include <map>
 #include <string>
 #include <vector>
@@ -27,6 +28,7 @@ along with this program. If not, see http://www.gnu.org/licenses.
 #include <iostream>
 #include <iomanip>
 #include <future>
+#include <thread>
 
 namespace {
 
@@ -36,6 +38,12 @@ using namespace sob;
 typedef function<double(FullInterface*,int)> test_ty;
 typedef map<int, map< int, double>> exec_results_ty;
 typedef map<string, map<int, exec_results_ty> > total_results_ty;
+typedef map<unsigned int, map<int, double>> books_results_ty; // pool size
+typedef map<string, map<int, double>> backtest_results_ty; // how
+
+
+const int DEF_NBOOKS = 1000;
+const int DEF_NBACKTESTS = 64; // norders are split between them
 
 
 const vector<int> DEF_NORDERS = {1000, 10000, 100000, 1000000};
@@ -53,11 +61,27 @@ proxies = {
 const vector< pair<string, const test_ty> >
 tests = {
         {"n_limits", TEST_n_limits},
+        {"n_limits_batch_1",
+            [](FullInterface *ob, int n){ return TEST_n_limits_batched(ob, n, 1); }},
+        {"n_limits_batch_10",
+            [](FullInterface *ob, int n){ return TEST_n_limits_batched(ob, n, 10); }},
+        {"n_limits_batch_100",
+            [](FullInterface *ob, int n){ return TEST_n_limits_batched(ob, n, 100); }},
+        {"n_limits_batch_1000",
+            [](FullInterface *ob, int n){ return TEST_n_limits_batched(ob, n, 1000); }},
         {"n_basics", TEST_n_basics},
+        {"n_basics_order_events", TEST_n_basics_order_events},
         {"n_pulls", TEST_n_pulls},
-        {"n_replaces", TEST_n_replaces}
+        {"n_replaces", TEST_n_replaces},
+        {"n_modifies", TEST_n_modifies},
+        {"n_pulls_under_insert_flood", TEST_n_pulls_under_insert_flood}
 };
 
+/* run again on inline (threadless) books, as "<name>_inline", to compare */
+const vector<string>
+inline_tests = { "n_limits", "n_basics", "n_replaces" };
+
+
 
 exec_results_ty
 exec_perf_tests( const test_ty& func,
@@ -81,6 +105,28 @@ display_performance_results( const total_results_ty& results,
                              std::ostream& out,
                              const vector<int>& norders);
 
+books_results_ty
+exec_books_perf_tests( const proxy_info_ty& proxy_info,
+                       int nruns,
+                       int nthreads,
+                       const vector<int>& norders );
+
+void
+display_books_results( const books_results_ty& results,
+                       std::ostream& out,
+                       const vector<int>& norders );
+
+backtest_results_ty
+exec_backtest_perf_tests( const proxy_info_ty& proxy_info,
+                          int nruns,
+                          int nthreads,
+                          const vector<int>& norders );
+
+void
+display_backtest_results( const backtest_results_ty& results,
+                          std::ostream& out,
+                          const vector<int>& norders );
+
 }; /* namespace */
 
 
@@ -117,28 +163,63 @@ run_performance_tests(int argc, char* argv[])
     cout<< endl;
 
     for( auto& test : tests ){
-        string test_name = test.first;
-        auto test_func = test.second;
-        cout<< endl << "BEGIN TEST - " << test_name << endl << endl;
-
-        for( auto& proxy_info : proxies ){
-            int proxy_denom = get<0>(proxy_info);
-            try{
-                results[test_name][proxy_denom] =
-                    exec_perf_tests(test_func, proxy_info, nruns_in_use,
-                                    nthreads_in_use, norders_in_use);
-            }catch(std::exception& e){
-                cerr<< e.what() << endl;
-                return 1;
+        bool also_inline = find(inline_tests.begin(), inline_tests.end(),
+                                test.first) != inline_tests.end();
+        for( bool is_inline : {false, true} ){
+            if( is_inline && !also_inline )
+                break;
+            string test_name = test.first + (is_inline ? "_inline" : "");
+            auto test_func = test.second;
+            cout<< endl << "BEGIN TEST - " << test_name << endl << endl;
+
+            /* books are created (on this thread) by exec_perf_tests */
+            SimpleOrderbook::UseInlineExecution(is_inline);
+            for( auto& proxy_info : proxies ){
+                int proxy_denom = get<0>(proxy_info);
+                try{
+                    results[test_name][proxy_denom] =
+                        exec_perf_tests(test_func, proxy_info, nruns_in_use,
+                                        nthreads_in_use, norders_in_use);
+                }catch(std::exception& e){
+                    SimpleOrderbook::UseInlineExecution(false);
+                    cerr<< e.what() << endl;
+                    return 1;
+                }
             }
+            SimpleOrderbook::UseInlineExecution(false);
+            cout<< "END TEST - " << test_name << endl << endl;
         }
-        cout<< "END TEST - " << test.first << endl << endl;
     }
 
+    books_results_ty books_results;
+    cout<< endl << "BEGIN TEST - n_books_zipf" << endl << endl;
+    try{
+        books_results = exec_books_perf_tests(proxies[0], nruns_in_use,
+                                              nthreads_in_use, norders_in_use);
+    }catch(std::exception& e){
+        cerr<< e.what() << endl;
+        return 1;
+    }
+    cout<< "END TEST - n_books_zipf" << endl << endl;
+
+    backtest_results_ty backtest_results;
+    cout<< endl << "BEGIN TEST - n_backtests" << endl << endl;
+    try{
+        backtest_results = exec_backtest_perf_tests(proxies[0], nruns_in_use,
+                                                    nthreads_in_use,
+                                                    norders_in_use);
+    }catch(std::exception& e){
+        cerr<< e.what() << endl;
+        return 1;
+    }
+    cout<< "END TEST - n_backtests" << endl << endl;
+
     streamsize old_precision = cout.precision();
     cout.precision(6);
     cout<< fixed << endl << endl;
     display_performance_results(results, std::cout, norders_in_use);
+    display_books_results(books_results, std::cout, norders_in_use);
+    display_backtest_results(backtest_results, std::cout, norders_in_use);
     {
         using namespace std::chrono;
         auto now_t = system_clock::to_time_t( system_clock::now() );
@@ -156,6 +237,8 @@ run_performance_tests(int argc, char* argv[])
         std::ofstream f("perf-test-" + buf);
         f << fixed;
         display_performance_results(results, f, norders_in_use);
+        display_books_results(books_results, f, norders_in_use);
+        display_backtest_results(backtest_results, f, norders_in_use);
     }
     cout<< endl << right;
     cout.precision(old_precision);
@@ -282,6 +365,129 @@ display_performance_results( const total_results_ty& results,
     }
 }
 
+
+/* dedicated dispatcher per book vs. one shared pool (a thread per core) */
+books_results_ty
+exec_books_perf_tests( const proxy_info_ty& proxy_info,
+                       int nruns,
+                       int nthreads,
+                       const vector<int>& norders )
+{
+    books_results_ty results;
+
+    auto& proxy = get<1>(proxy_info);
+    auto& args = get<2>(proxy_info).front();
+    unsigned int ncores = max(thread::hardware_concurrency(), 1u);
+
+    for( unsigned int pool_size : {0u, ncores} ){
+        for( int n : norders ){
+            cout<< "  NBOOKS " << DEF_NBOOKS << " - POOL " << pool_size
+                << " - NORDERS " << n << "::: ";
+            cout.flush();
+            double time_total = 0;
+            for( int i = 0; i < nruns; ++i ){
+                double t = TEST_n_books_zipf(proxy, get<0>(args), get<1>(args),
+                                             DEF_NBOOKS, n, pool_size, nthreads);
+                time_total += t;
+                cout<< t << " ";
+                cout.flush();
+            }
+            results[pool_size][n] = time_total / nruns;
+            cout<< endl;
+        }
+    }
+    return results;
+}
+
+
+void
+display_books_results( const books_results_ty& results,
+                       std::ostream& out,
+                       const vector<int>& norders )
+{
+    const size_t CW = 10;
+
+    out<< "n_books_zipf - " << DEF_NBOOKS << " books (pool size 0 = dedicated)"
+       << endl << endl << setw(CW) << "(pool)" << "| ";
+    for(int n: norders){
+        out<< setw(CW) << n;
+    }
+    out<< endl << string(CW, '-') << "|" << string(norders.size() * CW + 1, '-')
+       << endl;
+    for( auto& pool : results ){
+        out<< setw(CW) << pool.first << "| ";
+        for( auto& norder : pool.second ){
+            out<< setw(CW) << norder.second;
+        }
+        out<< endl;
+    }
+    out<< endl;
+}
+
+
+
+/* threaded books 'nthreads' at a time (std::async) vs. the BacktestRunner */
+backtest_results_ty
+exec_backtest_perf_tests( const proxy_info_ty& proxy_info,
+                          int nruns,
+                          int nthreads,
+                          const vector<int>& norders )
+{
+    backtest_results_ty results;
+
+    auto& proxy = get<1>(proxy_info);
+    auto& args = get<2>(proxy_info).front();
+    int ncores = static_cast<int>(max(thread::hardware_concurrency(), 1u));
+
+    for( bool use_runner : {false, true} ){
+        string how = use_runner ? "runner" : "async";
+        int nthreads_in_use = use_runner ? ncores : nthreads;
+        for( int n : norders ){
+            cout<< "  NBACKTESTS " << DEF_NBACKTESTS << " - " << how << " x "
+                << nthreads_in_use << " - NORDERS " << n << "::: ";
+            cout.flush();
+            double time_total = 0;
+            for( int i = 0; i < nruns; ++i ){
+                double t = TEST_n_backtests(proxy, get<0>(args), get<1>(args),
+                                            DEF_NBACKTESTS,
+                                            max(n / DEF_NBACKTESTS, 1),
+                                            nthreads_in_use, use_runner);
+                time_total += t;
+                cout<< t << " ";
+                cout.flush();
+            }
+            results[how][n] = time_total / nruns;
+            cout<< endl;
+        }
+    }
+    return results;
+}
+
+
+void
+display_backtest_results( const backtest_results_ty& results,
+                          std::ostream& out,
+                          const vector<int>& norders )
+{
+    const size_t CW = 10;
+
+    out<< "n_backtests - " << DEF_NBACKTESTS << " books (norders split between)"
+       << endl << endl << setw(CW) << "" << "| ";
+    for(int n: norders){
+        out<< setw(CW) << n;
+    }
+    out<< endl << string(CW, '-') << "|" << string(norders.size() * CW + 1, '-')
+       << endl;
+    for( auto& how : results ){
+        out<< setw(CW) << how.first << "| ";
+        for( auto& norder : how.second ){
+            out<< setw(CW) << norder.second;
+        }
+        out<< endl;
+    }
+    out<< endl;
+}
+
 }; /* namespace */
 
 #endif /* RUN_PERFORMANCE_TESTS */
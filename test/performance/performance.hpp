@@ -35,9 +35,33 @@ double TEST_##name(sob::FullInterface *full_orderbook, int n)
 /* tests/insert.cpp */
 DECL_PERFORMANCE_TEST_FUNC(n_limits);
 DECL_PERFORMANCE_TEST_FUNC(n_basics);
+DECL_PERFORMANCE_TEST_FUNC(n_basics_order_events);
+
+double
+TEST_n_limits_batched(sob::FullInterface *full_orderbook, int n, int batch_size);
 /* tests/pull.cpp */
 DECL_PERFORMANCE_TEST_FUNC(n_pulls);
 DECL_PERFORMANCE_TEST_FUNC(n_replaces);
+DECL_PERFORMANCE_TEST_FUNC(n_modifies);
+DECL_PERFORMANCE_TEST_FUNC(n_pulls_under_insert_flood);
+/* tests/pool.cpp */
+double
+TEST_n_books_zipf( const sob::DefaultFactoryProxy& proxy,
+                   double min_price,
+                   double max_price,
+                   int nbooks,
+                   int n,
+                   unsigned int pool_size,
+                   int nthreads );
+
+double
+TEST_n_backtests( const sob::DefaultFactoryProxy& proxy,
+                  double min_price,
+                  double max_price,
+                  int njobs,
+                  int n,
+                  int nthreads,
+                  bool use_runner );
 
 std::vector<double>
 generate_prices(const sob::FullInterface *ob, double min, double max, int n);
@@ -54,6 +78,10 @@ generate_limit_market_stop(int n, int limit_ratio=1);
 std::vector<sob::order_type>
 generate_limit_stop(int n, int limit_ratio=1);
 
+/* indices in [0, nindices) w/ zipf(s) weights; 0 is the most frequent */
+std::vector<size_t>
+generate_zipf_indices(int nindices, int n, double s=1.0);
+
 #endif /* RUN_PERFORMANCE_TESTS */
 
 #endif /* JO_PERFORMANCE_TEST */
@@ -21,6 +21,7 @@ along with this program. If not, see http://www.gnu.org/licenses.
 
 #include <random>
 #include <vector>
+#include <cmath>
 
 using namespace sob;
 
@@ -108,6 +109,22 @@ generate_limit_stop(int n, int limit_ratio)
     return ots;
 }
 
+std::vector<size_t>
+generate_zipf_indices(int nindices, int n, double s)
+{
+    std::vector<double> weights;
+    for( int k = 1; k <= nindices; ++k ){
+        weights.push_back( 1.0 / std::pow(k, s) );
+    }
+    std::discrete_distribution<size_t> zipf_distribution(weights.begin(),
+                                                         weights.end());
+    std::vector<size_t> idxs;
+    for( int i = 0; i < n; ++i ){
+        idxs.push_back( zipf_distribution(random_engine) );
+    }
+    return idxs;
+}
+
 #endif /* RUN_PERFORMANCE_TESTS */
 
 
@@ -21,6 +21,8 @@ along with this program. If not, see http://www.gnu.org/licenses.
 
 #include <chrono>
 #include <stdexcept>
+#include <thread>
+#include <atomic>
 
 using namespace std;
 using namespace sob;
@@ -87,4 +89,62 @@ TEST_n_basics(FullInterface *ob, int n)
     return sec.count();
 }
 
+
+/* n_basics w/ an L3 order-event subscriber drained by another thread */
+double
+TEST_n_basics_order_events(FullInterface *ob, int n)
+{
+    ManagementInterface *mi = dynamic_cast<ManagementInterface*>(ob);
+    OrderEventRing ring(1 << 16);
+    mi->subscribe_order_events(&ring);
+    atomic<bool> done(false);
+    thread consumer( [&](){
+        vector<order_event> events;
+        while( !done.load() ){
+            events.clear();
+            if( ring.pop(events) == 0 )
+                this_thread::yield();
+        }
+    });
+    double sec = 0;
+    try{
+        sec = TEST_n_basics(ob, n);
+    }catch(...){
+        done.store(true);
+        consumer.join();
+        mi->unsubscribe_order_events(&ring);
+        throw;
+    }
+    done.store(true);
+    consumer.join();
+    mi->unsubscribe_order_events(&ring);
+    return sec;
+}
+
+/* same flow as n_limits but sent through insert_orders 'batch_size' at a time */
+double
+TEST_n_limits_batched(FullInterface *ob, int n, int batch_size)
+{
+    auto prices = generate_prices(ob, ob->min_price(), ob->max_price(), n);
+    auto sizes = generate_sizes(1, 1000000, n);
+    auto buy_sells = generate_buy_sells(n);
+    OrderBatch batch(batch_size);
+
+    auto start = chrono::steady_clock::now();
+    for(int i = 0; i < n; ){
+        batch.clear();
+        for(int ii = 0; ii < batch_size && i < n; ++ii, ++i){
+            batch.add_limit_order( buy_sells[i], prices[i], sizes[i] );
+        }
+        for( auto& r : ob->insert_orders(batch) ){
+            if( !r ){
+                throw runtime_error("batch insert limit order failed");
+            }
+        }
+    }
+    auto end = chrono::steady_clock::now();
+    chrono::duration<double> sec = end - start;
+    return sec.count();
+}
+
 #endif /* RUN_PERFORMANCE_TESTS */
@@ -0,0 +1,152 @@
+/*
+Copyright (C) 2017 Jonathon Ogden < jeog.dev@gmail.com >
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see http://www.gnu.org/licenses.
+*/
+
+#include "../performance.hpp"
+#include "../../../include/backtest_runner.hpp"
+
+#ifdef RUN_PERFORMANCE_TESTS
+
+#include <chrono>
+#include <vector>
+#include <thread>
+#include <future>
+#include <stdexcept>
+
+using namespace std;
+using namespace sob;
+
+/*
+ * 'n' limit orders spread over 'nbooks' books w/ zipf-distributed flow
+ * (a few hot books, a long tail of quiet ones), pushed async from
+ * 'nthreads' threads; pool_size == 0 gives each book its own dispatcher
+ */
+double
+TEST_n_books_zipf( const DefaultFactoryProxy& proxy,
+                   double min_price,
+                   double max_price,
+                   int nbooks,
+                   int n,
+                   unsigned int pool_size,
+                   int nthreads )
+{
+    SimpleOrderbook::UseDispatcherPool(pool_size);
+    vector<FullInterface*> books;
+    for( int i = 0; i < nbooks; ++i ){
+        books.push_back( proxy.create(min_price, max_price) );
+    }
+    SimpleOrderbook::UseDispatcherPool(0);
+
+    auto book_idxs = generate_zipf_indices(nbooks, n);
+    auto prices = generate_prices(books[0], min_price, max_price, n);
+    auto sizes = generate_sizes(1, 1000000, n);
+    auto buy_sells = generate_buy_sells(n);
+
+    auto push_orders = [&](int beg, int end){
+        vector<future<id_type>> futs;
+        futs.reserve(end - beg);
+        for( int i = beg; i < end; ++i ){
+            futs.push_back( books[book_idxs[i]]->insert_limit_order_async(
+                buy_sells[i], prices[i], sizes[i]) );
+        }
+        for( auto& f : futs ){
+            if( !f.get() ){
+                throw runtime_error("insert limit order failed");
+            }
+        }
+    };
+
+    auto start = chrono::steady_clock::now();
+    vector<future<void>> producers;
+    for( int t = 0; t < nthreads; ++t ){
+        producers.push_back(
+            async(launch::async, push_orders, n * t / nthreads,
+                  n * (t + 1) / nthreads)
+        );
+    }
+    for( auto& p : producers ){
+        p.get();
+    }
+    auto end = chrono::steady_clock::now();
+
+    for( auto ob : books ){
+        proxy.destroy(ob);
+    }
+
+    chrono::duration<double> sec = end - start;
+    return sec.count();
+}
+
+
+/*
+ * 'njobs' independent backtests of 'n' orders each: w/ the BacktestRunner
+ * (inline books on a pool of 'nthreads') or, like exec_perf_test_async,
+ * 'nthreads' threaded books at a time via std::async
+ */
+double
+TEST_n_backtests( const DefaultFactoryProxy& proxy,
+                  double min_price,
+                  double max_price,
+                  int njobs,
+                  int n,
+                  int nthreads,
+                  bool use_runner )
+{
+    FullInterface *tmp = proxy.create(min_price, max_price);
+    auto prices = generate_prices(tmp, min_price, max_price, n);
+    proxy.destroy(tmp);
+    auto sizes = generate_sizes(1, 1000000, n);
+    auto buy_sells = generate_buy_sells(n);
+
+    auto stream = [&](FullInterface *ob){
+        for( int i = 0; i < n; ++i ){
+            if( !ob->insert_limit_order(buy_sells[i], prices[i], sizes[i]) ){
+                throw runtime_error("insert limit order failed");
+            }
+        }
+    };
+
+    auto start = chrono::steady_clock::now();
+    if( use_runner ){
+        BacktestRunner runner(nthreads);
+        for( int j = 0; j < njobs; ++j )
+            runner.add(proxy, min_price, max_price, stream);
+        for( auto& r : runner.run() ){
+            if( !r )
+                rethrow_exception(r.error);
+        }
+    }else{
+        for( int j = 0; j < njobs; ){
+            vector<FullInterface*> books;
+            vector<future<void>> futs;
+            for( int t = 0; t < nthreads && j < njobs; ++t, ++j ){
+                books.push_back( proxy.create(min_price, max_price) );
+                futs.push_back( async(launch::async, stream, books.back()) );
+            }
+            for( auto& f : futs )
+                f.get();
+            for( auto ob : books )
+                proxy.destroy(ob);
+        }
+    }
+    auto end = chrono::steady_clock::now();
+
+    chrono::duration<double> sec = end - start;
+    return sec.count();
+}
+
+
+#endif /* RUN_PERFORMANCE_TESTS */
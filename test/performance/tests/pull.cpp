@@ -22,6 +22,7 @@ along with this program. If not, see http://www.gnu.org/licenses.
 #include <chrono>
 #include <random>
 #include <vector>
+#include <future>
 #include <stdexcept>
 
 using namespace std;
@@ -139,5 +140,96 @@ TEST_n_replaces(FullInterface *ob, int n)
     return sec.count();
 }
 
+
+double
+TEST_n_modifies(FullInterface *ob, int n)
+{
+    double mid = ob->price_to_tick((ob->max_price() + ob->min_price()) / 2);
+    auto prices = generate_prices(ob, ob->min_price(), ob->max_price(), n);
+    auto sizes = generate_sizes(2, 1000000, n);
+    vector<pair<id_type, size_t>> active_ids;
+
+    /* no trades should occur */
+    for(int i = 0; i < n; ++i){
+        id_type id = ob->insert_limit_order( prices[i] < mid, prices[i],
+                                             sizes[i] );
+        if( !id ){
+            throw runtime_error("insert limit failed");
+        }
+        active_ids.emplace_back(id, sizes[i]);
+    }
+
+    random_shuffle(active_ids.begin(), active_ids.end());
+
+    /* size decreases, done in place */
+    auto start = chrono::steady_clock::now();
+    for( auto& p : active_ids ){
+        if( ob->modify_order(p.first, p.second / 2) != p.first ){
+            throw runtime_error("modify order failed");
+        }
+    }
+    auto end = chrono::steady_clock::now();
+    chrono::duration<double> sec = end - start;
+    return sec.count();
+}
+
+
+/*
+ * 'n' async pulls of live orders pushed while 'n' async inserts are being
+ * pushed (from another thread); returns the pulls' mean queue time, which
+ * shouldn't grow w/ 'n' since they skip ahead of the inserts
+ */
+double
+TEST_n_pulls_under_insert_flood(FullInterface *ob, int n)
+{
+    ManagementInterface *mi = dynamic_cast<ManagementInterface*>(ob);
+    double mid = ob->price_to_tick((ob->max_price() + ob->min_price()) / 2);
+    auto prices = generate_prices(ob, ob->min_price(), ob->max_price(), 2*n);
+    auto sizes = generate_sizes(1, 1000000, 2*n);
+    vector<id_type> active_ids;
+
+    /* no trades should occur */
+    for(int i = 0; i < n; ++i){
+        id_type id = ob->insert_limit_order( prices[i] < mid, prices[i],
+                                             sizes[i] );
+        if( !id ){
+            throw runtime_error("insert limit failed");
+        }
+        active_ids.push_back(id);
+    }
+    random_shuffle(active_ids.begin(), active_ids.end());
+    mi->reset_queue_time_stats();
+
+    auto flood = async(launch::async, [&](){
+        vector<future<id_type>> futs;
+        futs.reserve(n);
+        for( int i = n; i < 2*n; ++i ){
+            futs.push_back( ob->insert_limit_order_async( prices[i] < mid,
+                                                          prices[i], sizes[i] ) );
+        }
+        for( auto& f : futs ){
+            if( !f.get() ){
+                throw runtime_error("insert limit failed");
+            }
+        }
+    });
+
+    vector<future<id_type>> pulls;
+    pulls.reserve(n);
+    for( id_type id : active_ids ){
+        pulls.push_back( ob->pull_order_async(id) );
+    }
+    for( auto& f : pulls ){
+        if( !f.get() ){
+            throw runtime_error("pull order failed");
+        }
+    }
+    flood.get();
+
+    chrono::duration<double> sec = mi->get_cancel_queue_time_stats().mean();
+    return sec.count();
+}
+
+
 #endif /* RUN_PERFORMANCE_TESTS */
 